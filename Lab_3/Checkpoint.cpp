@@ -0,0 +1,154 @@
+#include "Checkpoint.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+using namespace std;
+
+static const char     CHECKPOINT_MAGIC[4] = { 'L', '3', 'C', 'K' };
+static const uint32_t BYTE_ORDER_MARK     = 0x01020304;
+static const size_t   HEADER_BYTES        = 4 + 4 + 4 + CHECKPOINT_RULES_BYTES;
+
+// ---- writer ----------------------------------------------------------------
+
+CheckpointWriter::CheckpointWriter(const string& rules) {
+    char name[CHECKPOINT_RULES_BYTES] = {};
+    memcpy(name, rules.data(), min(rules.size(), CHECKPOINT_RULES_BYTES - 1));
+    inlineBytes(CHECKPOINT_MAGIC, 4);
+    value(CHECKPOINT_VERSION);
+    value(BYTE_ORDER_MARK);
+    inlineBytes(name, sizeof name);
+}
+
+void CheckpointWriter::inlineBytes(const void* p, size_t bytes) {
+    // runs of small fields share one piece
+    if (pieces.empty() || pieces.back().data != nullptr) pieces.push_back({ nullptr, small.size(), 0 });
+    small.insert(small.end(), (const uint8_t*)p, (const uint8_t*)p + bytes);
+    pieces.back().bytes += bytes;
+}
+
+void CheckpointWriter::column(const void* p, size_t bytes) {
+    value((uint64_t)bytes);
+    if (bytes > 0) pieces.push_back({ p, 0, bytes });
+}
+
+// writev takes at most IOV_MAX pieces and about 2 GB per call, so a big
+// pool can still take a few calls; each resumes where the last one stopped
+bool CheckpointWriter::commit(const string& path) {
+    vector<iovec> iov(pieces.size());
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        const void* p = pieces[i].data ? pieces[i].data : small.data() + pieces[i].offset;
+        iov[i].iov_base = const_cast<void*>(p);
+        iov[i].iov_len = pieces[i].bytes;
+    }
+    string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    size_t first = 0;
+    while (first < iov.size()) {
+        int n = (int)min(iov.size() - first, (size_t)IOV_MAX);
+        ssize_t done = writev(fd, &iov[first], n);
+        if (done < 0 && errno == EINTR) continue;
+        if (done <= 0) break;
+        while (first < iov.size() && (size_t)done >= iov[first].iov_len) {
+            done -= iov[first].iov_len;
+            ++first;
+        }
+        if (done > 0) {
+            iov[first].iov_base = (char*)iov[first].iov_base + done;
+            iov[first].iov_len -= done;
+        }
+    }
+    bool written = first == iov.size() && fsync(fd) == 0;
+    if (::close(fd) != 0) written = false;
+    if (!written || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ---- reader ----------------------------------------------------------------
+
+CheckpointReader::CheckpointReader(const string& path) : data(nullptr), size(0), pos(0), failed(false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_BYTES) {
+        ::close(fd);
+        return;
+    }
+    void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) return;
+    const uint8_t* p = (const uint8_t*)m;
+    uint32_t version, mark;
+    memcpy(&version, p + 4, 4);
+    memcpy(&mark, p + 8, 4);
+    if (memcmp(p, CHECKPOINT_MAGIC, 4) != 0 || version != CHECKPOINT_VERSION || mark != BYTE_ORDER_MARK) {
+        munmap(m, st.st_size);
+        return;
+    }
+    madvise(m, st.st_size, MADV_SEQUENTIAL);
+    data = p;
+    size = st.st_size;
+    pos = HEADER_BYTES;
+}
+
+CheckpointReader::~CheckpointReader() {
+    if (data) munmap((void*)data, size);
+}
+
+string CheckpointReader::rules() const {
+    if (!data) return string();
+    const char* name = (const char*)data + 12;
+    return string(name, strnlen(name, CHECKPOINT_RULES_BYTES));
+}
+
+bool CheckpointReader::take(void* dst, size_t bytes) {
+    if (!ok() || size - pos < bytes) {
+        failed = true;
+        return false;
+    }
+    if (bytes > 0) memcpy(dst, data + pos, bytes);
+    pos += bytes;
+    return true;
+}
+
+size_t CheckpointReader::nextColumnBytes() const {
+    if (!ok() || size - pos < sizeof(uint64_t)) return 0;
+    uint64_t bytes;
+    memcpy(&bytes, data + pos, sizeof bytes);
+    return bytes;
+}
+
+bool CheckpointReader::expectColumn(size_t bytes) {
+    if (!ok() || size - pos < sizeof(uint64_t) || nextColumnBytes() != bytes ||
+        size - pos - sizeof(uint64_t) < bytes) {
+        failed = true;
+    }
+    return ok();
+}
+
+bool CheckpointReader::column(void* dst, size_t bytes) {
+    uint64_t stored = 0;
+    if (!value(stored)) return false;
+    if (stored != bytes) {
+        failed = true;
+        return false;
+    }
+    return take(dst, bytes);
+}
+
+bool CheckpointReader::text(string& s) {
+    size_t bytes = nextColumnBytes();
+    if (bytes > size - pos) failed = true;
+    if (!ok()) return false;
+    s.resize(bytes);
+    return column(&s[0], bytes);
+}
@@ -0,0 +1,103 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+// Binary snapshot of a whole Game, for resuming long runs.
+//
+// File layout:
+//   header   "L3CK", u32 version, u32 byte-order mark, char[16] rules name
+//   fields   in the order the writer put them, each either
+//              a value    raw bytes of one trivially copyable field, or
+//              a column   u64 byte count, then the bytes
+// Columns are the pool's and the live set's arrays as they sit in memory,
+// so a snapshot is written in host byte order; the mark rejects a file
+// from a machine of the other order. Each part saves and loads its own
+// fields in the same order, there are no tags.
+
+const uint32_t CHECKPOINT_VERSION = 2; // 2: 64-bit game seed
+const size_t   CHECKPOINT_RULES_BYTES = 16;
+
+// Collects a snapshot and writes it in one go. Columns are kept by pointer,
+// not copied, so they must stay untouched until commit().
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(const string& rules);
+
+    template <class T> void value(const T& v);
+    void column(const void* data, size_t bytes);
+    template <class T> void column(const vector<T>& v) { column(v.data(), v.size() * sizeof(T)); }
+    void text(const string& s) { column(s.data(), s.size()); }
+
+    // One gathered write into <path>.tmp, fsync, then rename over path, so
+    // a crash mid-write leaves the previous snapshot intact.
+    bool commit(const string& path);
+
+private:
+    void inlineBytes(const void* data, size_t bytes);
+
+    struct Piece {
+        const void* data;           // nullptr: the bytes are in small at offset
+        size_t      offset;
+        size_t      bytes;
+    };
+    vector<uint8_t> small;          // header, values and column lengths
+    vector<Piece>   pieces;
+};
+
+// Memory-maps a snapshot and hands its fields back in order. A mismatch
+// (truncated file, wrong length) clears ok() and every later read fails,
+// so callers read everything and check ok() once at the end.
+class CheckpointReader {
+public:
+    explicit CheckpointReader(const string& path);
+    ~CheckpointReader();
+
+    bool   ok() const { return data != nullptr && !failed; }
+    string rules() const;           // name of the rule set that wrote it
+
+    template <class T> bool value(T& v);
+    size_t nextColumnBytes() const; // length of the next column, 0 if none
+    bool   expectColumn(size_t bytes); // next column is `bytes` long and in the file, else clears ok()
+    void   fail() { failed = true; } // a loader found values it cannot use; clears ok()
+    bool   column(void* dst, size_t bytes); // exactly `bytes` long
+    template <class T> bool column(vector<T>& v);
+    bool   text(string& s);
+
+private:
+    bool take(void* dst, size_t bytes);
+
+    const uint8_t* data;
+    size_t         size;
+    size_t         pos;
+    bool           failed;
+};
+
+template <class T>
+void CheckpointWriter::value(const T& v) {
+    static_assert(is_trivially_copyable<T>::value, "checkpoint values are raw bytes");
+    inlineBytes(&v, sizeof v);
+}
+
+template <class T>
+bool CheckpointReader::value(T& v) {
+    static_assert(is_trivially_copyable<T>::value, "checkpoint values are raw bytes");
+    return take(&v, sizeof v);
+}
+
+template <class T>
+bool CheckpointReader::column(vector<T>& v) {
+    size_t bytes = nextColumnBytes();
+    if (bytes % sizeof(T) != 0 || bytes > size - pos) failed = true; // before resizing to it
+    if (!ok()) return false;
+    v.resize(bytes / sizeof(T));
+    return column(v.data(), bytes);
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef COUNTERRNG_H
+#define COUNTERRNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "Rng.h"
+using namespace std;
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// Output is a pure function of (key, counter): no state is carried between
+// calls, so any block can be computed on any thread in any order.
+inline void philox4x32(const uint32_t in[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = in[0], c1 = in[1], c2 = in[2], c3 = in[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; ++r) {
+        uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+// 32 random bits -> float in [0,1), same 24-bit grid as uniform_real_distribution<float>
+inline float toUniform(uint32_t bits) {
+    return (bits >> 8) * (1.0f / 16777216.0f);
+}
+
+// Random stream keyed by (seed, game id) and positioned at (round, player).
+// Two streams with the same four numbers produce identical draws, so a duel
+// keyed this way replays bit for bit wherever and whenever it runs.
+// Satisfies UniformRandomBitGenerator, so <random> distributions work on it.
+class CounterRng {
+public:
+    typedef uint32_t result_type;
+
+    CounterRng(uint64_t seed, uint64_t game, uint32_t round, uint32_t player) {
+        keyFor(seed, game, key);
+        ctr[0] = round;
+        ctr[1] = player;
+        ctr[2] = 0;                     // block index, low word
+        ctr[3] = 0;                     // block index, high word
+        used = 4;
+    }
+
+    // Philox key of every stream of one (seed, game id); the counter is
+    // (round, player, block index low, block index high), blocks from 0.
+    static void keyFor(uint64_t seed, uint64_t game, uint32_t out[2]) {
+        uint64_t sm = seed ^ (game * 0x9E3779B97F4A7C15ULL);
+        uint64_t k = splitmix64(sm);
+        out[0] = (uint32_t)k;
+        out[1] = (uint32_t)(k >> 32);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        if (used == 4) refill();
+        return buf[used++];
+    }
+
+    // Bulk API: the next n draws as floats in [0,1), four per Philox block.
+    void fillUniform(float* out, size_t n) {
+        size_t i = 0;
+        while (i < n && used < 4) out[i++] = toUniform(buf[used++]);
+        uint32_t block[4];
+        for (; i + 4 <= n; i += 4) {
+            philox4x32(ctr, key, block);
+            advance();
+            for (int j = 0; j < 4; ++j) out[i + j] = toUniform(block[j]);
+        }
+        while (i < n) out[i++] = toUniform((*this)());
+    }
+
+private:
+    void refill() {
+        philox4x32(ctr, key, buf);
+        advance();
+        used = 0;
+    }
+
+    void advance() {
+        if (++ctr[2] == 0) ++ctr[3];
+    }
+
+    uint32_t key[2];
+    uint32_t ctr[4];
+    uint32_t buf[4];
+    int      used;                      // draws consumed from buf
+};
+
+// float in [0,1) for one attack roll, the same value fillUniform gives
+inline float uniformFloat(CounterRng& rng) {
+    return toUniform(rng());
+}
+
+#endif
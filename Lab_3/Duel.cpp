@@ -0,0 +1,101 @@
+#include "Duel.h"
+#include "Stats.h"
+#include <climits>
+#include <cmath>
+using namespace std;
+
+// one attack, reported to the observer if there is one
+template <class Rules>
+static void swingAt(BasicRPG<Rules> attacker, BasicRPG<Rules> defender, float r,
+                    SwingObserver* watch) {
+    int before = defender.getHitsTaken();
+    attacker.attack(defender, r);
+    if (watch) watch->swing(attacker.getId(), defender.getId(), defender.getHitsTaken() != before);
+}
+
+template <class Rules, class Engine>
+DuelResult simulateDuel(BasicRPG<Rules> p1, BasicRPG<Rules> p2, Engine& rng,
+                        SwingObserver* watch) {
+    int swings = 0;
+    while (p1.isAlive() && p2.isAlive()) {
+        swingAt(p1, p2, uniformFloat(rng), watch);
+        ++swings;
+        if (!p2.isAlive()) break;
+        swingAt(p2, p1, uniformFloat(rng), watch);
+        ++swings;
+    }
+    if (p1.isAlive()) return { p1.getId(), p2.getId(), swings };
+    return { p2.getId(), p1.getId(), swings };
+}
+
+// cap on a sampled gap so KO swing sums and 2 * ko stay in range
+template <class Rules>
+static constexpr int never() { return INT_MAX / (2 * (Rules::MAX_HITS_TAKEN + 1)); }
+
+// Swings a fighter needs to land one hit with probability p (geometric, >= 1).
+template <class Rules, class Engine>
+static int swingsToHit(double p, Engine& rng) {
+    const int NEVER = never<Rules>();
+    if (p >= 1.0) return 1;
+    if (p <= 0.0) return NEVER;         // can never land a hit
+    uniform_real_distribution<double> dis(0.0, 1.0);
+    double u = 1.0 - dis(rng);          // (0,1]
+    if (u > 1.0 - p) return 1;          // first swing lands, skip the logs
+    double gap = floor(log(u) / log1p(-p));
+    return gap >= NEVER ? NEVER : 1 + (int)gap;
+}
+
+// Each fighter's hit chance is fixed for the whole duel (attack() hits when
+// r > HIT_FACTOR * opponent luck), so the swing on which each side lands its
+// k-th hit is a sum of k geometric gaps. p1 swings first, so p1 wins if its
+// KO swing comes no later than p2's. That is one draw per hit needed instead
+// of one per swing, and the same outcome distribution as simulateDuel.
+template <class Rules, class Engine>
+DuelResult resolveDuel(BasicRPG<Rules> p1, BasicRPG<Rules> p2, Engine& rng) {
+    constexpr int MAX_HITS_TAKEN = Rules::MAX_HITS_TAKEN;
+    constexpr float HIT_FACTOR = Rules::HIT_FACTOR;
+    int need1 = MAX_HITS_TAKEN - p2.getHitsTaken();   // hits p1 must land
+    int need2 = MAX_HITS_TAKEN - p1.getHitsTaken();   // hits p2 must land
+    if (need2 <= 0) return { p2.getId(), p1.getId(), 0 };
+    if (need1 <= 0) return { p1.getId(), p2.getId(), 0 };
+
+    double hit1 = 1.0 - HIT_FACTOR * p2.getLuck();
+    double hit2 = 1.0 - HIT_FACTOR * p1.getLuck();
+
+    // own-swing index of every hit each side would land
+    int at1[MAX_HITS_TAKEN], at2[MAX_HITS_TAKEN];
+    int t = 0;
+    for (int k = 0; k < need1; ++k) at1[k] = (t += swingsToHit<Rules>(hit1, rng));
+    t = 0;
+    for (int k = 0; k < need2; ++k) at2[k] = (t += swingsToHit<Rules>(hit2, rng));
+
+    int ko1 = at1[need1 - 1];
+    int ko2 = at2[need2 - 1];
+
+    // if neither side can ever hit, the loop would never end; p1 takes it
+    if (ko1 <= ko2) {
+        int landed = 0;                 // p2 hits before p1's KO swing
+        while (at2[landed] < ko1) ++landed;
+        p1.setHitsTaken(p1.getHitsTaken() + landed);
+        p2.setHitsTaken(MAX_HITS_TAKEN);
+        LAB3_COUNT(STAT_ATTACKS, 2 * ko1 - 1);
+        LAB3_COUNT(STAT_HITS, need1 + landed);
+        LAB3_COUNT(STAT_MISSES, 2 * ko1 - 1 - need1 - landed);
+        return { p1.getId(), p2.getId(), 2 * ko1 - 1 };
+    }
+    int landed = 0;                     // p1 hits up to p2's KO swing
+    while (at1[landed] <= ko2) ++landed;
+    p2.setHitsTaken(p2.getHitsTaken() + landed);
+    p1.setHitsTaken(MAX_HITS_TAKEN);
+    LAB3_COUNT(STAT_ATTACKS, 2 * ko2);
+    LAB3_COUNT(STAT_HITS, need2 + landed);
+    LAB3_COUNT(STAT_MISSES, 2 * ko2 - need2 - landed);
+    return { p2.getId(), p1.getId(), 2 * ko2 };
+}
+
+#define LAB3_INSTANTIATE_DUEL(R)                                                              \
+    template DuelResult simulateDuel<R, GameRng>(BasicRPG<R>, BasicRPG<R>, GameRng&, SwingObserver*); \
+    template DuelResult resolveDuel<R, GameRng>(BasicRPG<R>, BasicRPG<R>, GameRng&);               \
+    template DuelResult simulateDuel<R, CounterRng>(BasicRPG<R>, BasicRPG<R>, CounterRng&, SwingObserver*); \
+    template DuelResult resolveDuel<R, CounterRng>(BasicRPG<R>, BasicRPG<R>, CounterRng&);
+LAB3_FOR_EACH_RULES(LAB3_INSTANTIATE_DUEL)
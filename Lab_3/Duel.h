@@ -0,0 +1,40 @@
+#ifndef DUEL_H
+#define DUEL_H
+
+#include "RPG.h"
+#include "Rng.h"
+#include "CounterRng.h"
+using namespace std;
+
+struct DuelResult {
+    int winner;   // pool index
+    int loser;    // pool index
+    int swings;   // attacks thrown, both sides
+};
+
+enum class DuelMode {
+    Analytic,     // resolveDuel: sample the outcome directly
+    Swings,       // simulateDuel: one attack() per swing
+    Interleaved,  // bracket duels as coroutines stepped together (DuelScheduler.h),
+                  // same results as Swings; Swings when built without C++20
+    Batched       // bracket duels eight at a time in SIMD lanes (DuelKernel.h),
+                  // same results as Swings
+};
+
+// Told about every swing of a simulateDuel (tracing, replays).
+class SwingObserver {
+public:
+    virtual ~SwingObserver() {}
+    virtual void swing(int attacker, int defender, bool hit) = 0; // pool indices
+};
+
+// p1 swings first, then they alternate until one is KO'd.
+// Both leave the loser at Rules::MAX_HITS_TAKEN and the winner with the hits it took.
+// Instantiated in Duel.cpp for every rule set, with GameRng and CounterRng.
+template <class Rules, class Engine>
+DuelResult simulateDuel(BasicRPG<Rules> p1, BasicRPG<Rules> p2, Engine& rng,
+                        SwingObserver* watch = nullptr);
+template <class Rules, class Engine>
+DuelResult resolveDuel(BasicRPG<Rules> p1, BasicRPG<Rules> p2, Engine& rng);
+
+#endif
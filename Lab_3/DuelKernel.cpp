@@ -0,0 +1,385 @@
+#include "DuelKernel.h"
+#include "CounterRng.h"
+#include "RPG.h"
+#include "Stats.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LAB3_X86 1
+#else
+#define LAB3_X86 0
+#endif
+
+using namespace std;
+
+// ---- scalar --------------------------------------------------------------
+
+template <class Rules>
+static void scalarBatch(PlayerPool& pool, const int* p1, const int* p2, long long n,
+                        uint64_t seed, uint64_t game, uint32_t round, DuelResult* out) {
+    for (long long i = 0; i < n; ++i) {
+        BasicRPG<Rules> a(&pool, p1[i]), b(&pool, p2[i]);
+        // neither can ever land a hit: simulateDuel would never return,
+        // so these go to p1 as in resolveDuel and the vector kernels
+        if (Rules::HIT_FACTOR * b.getLuck() >= 1.0f && Rules::HIT_FACTOR * a.getLuck() >= 1.0f &&
+            a.isAlive() && b.isAlive()) {
+            out[i] = { p1[i], p2[i], 0 };
+            continue;
+        }
+        CounterRng rng(seed, game, round, (uint32_t)p1[i]);
+        out[i] = simulateDuel(a, b, rng);
+    }
+}
+
+// ---- AVX2 ----------------------------------------------------------------
+
+#if LAB3_X86
+
+#define LAB3_AVX2 __attribute__((target("avx2")))
+
+// 32x32 -> 64 multiply of every lane by m, split into low and high halves
+LAB3_AVX2 static inline void mulhilo(__m256i a, __m256i m, __m256i& lo, __m256i& hi) {
+    __m256i even = _mm256_mul_epu32(a, m);
+    __m256i odd  = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+    lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+// philox4x32 for eight counters that differ only in the second word, for B
+// consecutive blocks at once (independent chains, so the multiplies overlap).
+// ks holds the ten rounds' keys, broadcast.
+template <int B>
+LAB3_AVX2 static inline void philox8(uint32_t round, __m256i player, uint32_t first_block,
+                                     const __m256i ks[10][2], __m256i w[][4]) {
+    const __m256i M0 = _mm256_set1_epi32((int)0xD2511F53u);
+    const __m256i M1 = _mm256_set1_epi32((int)0xCD9E8D57u);
+    __m256i c0[B], c1[B], c2[B], c3[B];
+    for (int j = 0; j < B; ++j) {
+        c0[j] = _mm256_set1_epi32((int)round);
+        c1[j] = player;
+        c2[j] = _mm256_set1_epi32((int)(first_block + j));
+        c3[j] = _mm256_setzero_si256();
+    }
+    for (int r = 0; r < 10; ++r) {
+        for (int j = 0; j < B; ++j) {
+            __m256i lo0, hi0, lo1, hi1;
+            mulhilo(c0[j], M0, lo0, hi0);
+            mulhilo(c2[j], M1, lo1, hi1);
+            c0[j] = _mm256_xor_si256(_mm256_xor_si256(hi1, c1[j]), ks[r][0]);
+            c2[j] = _mm256_xor_si256(_mm256_xor_si256(hi0, c3[j]), ks[r][1]);
+            c1[j] = lo1;
+            c3[j] = lo0;
+        }
+    }
+    for (int j = 0; j < B; ++j) {
+        w[j][0] = c0[j]; w[j][1] = c1[j]; w[j][2] = c2[j]; w[j][3] = c3[j];
+    }
+}
+
+// philox8 for B blocks from first_block, as floats in [0,1): u[4 * k + j]
+// is word j of block k, the value toUniform gives.
+template <int B>
+LAB3_AVX2 static inline void uniforms8(uint32_t round, __m256i player, uint32_t first_block,
+                                       const __m256i ks[10][2], __m256 u[]) {
+    const __m256 scale = _mm256_set1_ps(1.0f / 16777216.0f);
+    __m256i w[B][4];
+    philox8<B>(round, player, first_block, ks, w);
+    for (int k = 0; k < B; ++k)
+        for (int j = 0; j < 4; ++j)
+            u[4 * k + j] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(w[k][j], 8)), scale);
+}
+
+// Eight duels in lockstep: swing s of every lane uses word s % 4 of Philox
+// block s / 4 of its own stream, which is the draw simulateDuel would take.
+// Even swings are p1's, odd ones p2's. A lane stops counting once someone
+// is KO'd; the batch ends when every lane has. The uniforms are drawn
+// before the compares that use them: every block the shortest possible
+// duel needs up front, then one block at a time while a lane is still going.
+template <class Rules>
+LAB3_AVX2 static void avx2Batch(PlayerPool& pool, const int* p1, const int* p2, long long n,
+                                uint64_t seed, uint64_t game, uint32_t round, DuelResult* out) {
+    uint32_t key[2];
+    CounterRng::keyFor(seed, game, key);
+    __m256i ks[10][2];
+    for (int r = 0; r < 10; ++r) {
+        ks[r][0] = _mm256_set1_epi32((int)(key[0] + r * 0x9E3779B9u));
+        ks[r][1] = _mm256_set1_epi32((int)(key[1] + r * 0xBB67AE85u));
+    }
+    const int*   hits = &pool.hitsTaken(0);
+    const float* luck = &pool.luckOf(0);
+    const __m256  hit_factor = _mm256_set1_ps(Rules::HIT_FACTOR);
+    const __m256  one = _mm256_set1_ps(1.0f);
+    const __m256i ko = _mm256_set1_epi32(Rules::MAX_HITS_TAKEN - 1); // hits > ko means KO'd
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i all = _mm256_set1_epi32(-1);
+    long long attacks = 0, landed = 0;
+
+    for (long long base = 0; base < n; base += 8) {
+        int m = (int)min<long long>(8, n - base);
+        __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(m), lane);
+        // short batches repeat the last duel in the spare lanes, masked off
+        __m256i idx = _mm256_min_epi32(lane, _mm256_set1_epi32(m - 1));
+        __m256i a, b;
+        if (m == 8) {
+            a = _mm256_loadu_si256((const __m256i*)(p1 + base));
+            b = _mm256_loadu_si256((const __m256i*)(p2 + base));
+        } else {
+            a = _mm256_i32gather_epi32(p1 + base, idx, 4);
+            b = _mm256_i32gather_epi32(p2 + base, idx, 4);
+        }
+
+        __m256i h1 = _mm256_i32gather_epi32(hits, a, 4);
+        __m256i h2 = _mm256_i32gather_epi32(hits, b, 4);
+        __m256  thr1 = _mm256_mul_ps(hit_factor, _mm256_i32gather_ps(luck, b, 4)); // p1 hits when u > thr1
+        __m256  thr2 = _mm256_mul_ps(hit_factor, _mm256_i32gather_ps(luck, a, 4));
+        __m256i swings = _mm256_setzero_si256();
+
+        // done: a side is already KO'd, or neither can ever land a hit
+        // (simulateDuel would never return; resolveDuel gives those to p1)
+        __m256i stuck = _mm256_castps_si256(_mm256_and_ps(_mm256_cmp_ps(thr1, one, _CMP_GE_OQ),
+                                                          _mm256_cmp_ps(thr2, one, _CMP_GE_OQ)));
+        __m256i done = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(h1, ko),
+                                                       _mm256_cmpgt_epi32(h2, ko)),
+                                       _mm256_or_si256(stuck, _mm256_xor_si256(valid, all)));
+
+        // The shortest possible duel needs 2 * MAX_HITS_TAKEN - 1 swings, so
+        // those blocks are drawn together up front; later ones one at a time.
+        const int FIRST = (2 * Rules::MAX_HITS_TAKEN - 1 + 3) / 4;
+        __m256 u[4 * FIRST];
+        uniforms8<FIRST>(round, a, 0, ks, u);
+        for (uint32_t block = 0; !_mm256_testc_si256(done, all); ++block) {
+            if (block >= (uint32_t)FIRST) uniforms8<1>(round, a, block, ks, u);
+            const __m256* draws = u + 4 * (block < (uint32_t)FIRST ? block : 0);
+            for (int j = 0; j < 4; ++j) {
+                __m256i active = _mm256_andnot_si256(done, all);
+                __m256i hit;
+                if (j % 2 == 0) {       // blocks hold four draws, so even j is p1's swing
+                    hit = _mm256_and_si256(active, _mm256_castps_si256(_mm256_cmp_ps(draws[j], thr1, _CMP_GT_OQ)));
+                    h2 = _mm256_sub_epi32(h2, hit);
+                } else {
+                    hit = _mm256_and_si256(active, _mm256_castps_si256(_mm256_cmp_ps(draws[j], thr2, _CMP_GT_OQ)));
+                    h1 = _mm256_sub_epi32(h1, hit);
+                }
+                swings = _mm256_sub_epi32(swings, active);
+#ifdef LAB3_STATS
+                attacks += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(active)));
+                landed  += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(hit)));
+#endif
+                done = _mm256_or_si256(done, _mm256_or_si256(_mm256_cmpgt_epi32(h1, ko),
+                                                             _mm256_cmpgt_epi32(h2, ko)));
+            }
+        }
+
+        alignas(32) int hit1[8], hit2[8], sw[8];
+        _mm256_store_si256((__m256i*)hit1, h1);
+        _mm256_store_si256((__m256i*)hit2, h2);
+        _mm256_store_si256((__m256i*)sw, swings);
+        for (int k = 0; k < m; ++k) {
+            long long i = base + k;
+            pool.hitsTaken(p1[i]) = hit1[k];
+            pool.hitsTaken(p2[i]) = hit2[k];
+            bool p1_alive = hit1[k] < Rules::MAX_HITS_TAKEN;
+            out[i] = p1_alive ? DuelResult{ p1[i], p2[i], sw[k] } : DuelResult{ p2[i], p1[i], sw[k] };
+        }
+    }
+    LAB3_COUNT(STAT_DUELS, n);
+    LAB3_COUNT(STAT_ATTACKS, attacks);
+    LAB3_COUNT(STAT_HITS, landed);
+    LAB3_COUNT(STAT_MISSES, attacks - landed);
+    (void)attacks;
+    (void)landed;
+}
+
+// ---- AVX-512 -------------------------------------------------------------
+
+#define LAB3_AVX512 __attribute__((target("avx512f")))
+
+// GCC 12's avx512fintrin.h trips -Wmaybe-uninitialized on its own
+// _mm512_undefined_epi32() placeholders
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+LAB3_AVX512 static inline void mulhilo16(__m512i a, __m512i m, __m512i& lo, __m512i& hi) {
+    __m512i even = _mm512_mul_epu32(a, m);
+    __m512i odd  = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), m);
+    lo = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+    hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+}
+
+// philox8 with sixteen lanes; ks holds the ten rounds' keys, broadcast
+template <int B>
+LAB3_AVX512 static inline void philox16(uint32_t round, __m512i player, uint32_t first_block,
+                                        const __m512i ks[10][2], __m512i w[][4]) {
+    const __m512i M0 = _mm512_set1_epi32((int)0xD2511F53u);
+    const __m512i M1 = _mm512_set1_epi32((int)0xCD9E8D57u);
+    __m512i c0[B], c1[B], c2[B], c3[B];
+    for (int j = 0; j < B; ++j) {
+        c0[j] = _mm512_set1_epi32((int)round);
+        c1[j] = player;
+        c2[j] = _mm512_set1_epi32((int)(first_block + j));
+        c3[j] = _mm512_setzero_si512();
+    }
+    for (int r = 0; r < 10; ++r) {
+        for (int j = 0; j < B; ++j) {
+            __m512i lo0, hi0, lo1, hi1;
+            mulhilo16(c0[j], M0, lo0, hi0);
+            mulhilo16(c2[j], M1, lo1, hi1);
+            c0[j] = _mm512_ternarylogic_epi32(hi1, c1[j], ks[r][0], 0x96); // three-way xor
+            c2[j] = _mm512_ternarylogic_epi32(hi0, c3[j], ks[r][1], 0x96);
+            c1[j] = lo1;
+            c3[j] = lo0;
+        }
+    }
+    for (int j = 0; j < B; ++j) {
+        w[j][0] = c0[j]; w[j][1] = c1[j]; w[j][2] = c2[j]; w[j][3] = c3[j];
+    }
+}
+
+// uniforms8 with sixteen lanes
+template <int B>
+LAB3_AVX512 static inline void uniforms16(uint32_t round, __m512i player, uint32_t first_block,
+                                          const __m512i ks[10][2], __m512 u[]) {
+    const __m512 scale = _mm512_set1_ps(1.0f / 16777216.0f);
+    __m512i w[B][4];
+    philox16<B>(round, player, first_block, ks, w);
+    for (int k = 0; k < B; ++k)
+        for (int j = 0; j < 4; ++j)
+            u[4 * k + j] = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(w[k][j], 8)), scale);
+}
+
+// avx2Batch with sixteen lanes, mask registers, and scattered hit counts
+template <class Rules>
+LAB3_AVX512 static void avx512Batch(PlayerPool& pool, const int* p1, const int* p2, long long n,
+                                    uint64_t seed, uint64_t game, uint32_t round, DuelResult* out) {
+    uint32_t key[2];
+    CounterRng::keyFor(seed, game, key);
+    __m512i ks[10][2];
+    for (int r = 0; r < 10; ++r) {
+        ks[r][0] = _mm512_set1_epi32((int)(key[0] + r * 0x9E3779B9u));
+        ks[r][1] = _mm512_set1_epi32((int)(key[1] + r * 0xBB67AE85u));
+    }
+    int*         hits = &pool.hitsTaken(0);
+    const float* luck = &pool.luckOf(0);
+    const __m512  hit_factor = _mm512_set1_ps(Rules::HIT_FACTOR);
+    const __m512  one = _mm512_set1_ps(1.0f);
+    const __m512i ko = _mm512_set1_epi32(Rules::MAX_HITS_TAKEN - 1);
+    const __m512i inc = _mm512_set1_epi32(1);
+    long long attacks = 0, landed = 0;
+
+    for (long long base = 0; base < n; base += 16) {
+        int m = (int)min<long long>(16, n - base);
+        __mmask16 valid = (__mmask16)((1u << m) - 1);
+        __m512i a = _mm512_maskz_loadu_epi32(valid, p1 + base);
+        __m512i b = _mm512_maskz_loadu_epi32(valid, p2 + base);
+
+        __m512i h1 = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), valid, a, hits, 4);
+        __m512i h2 = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), valid, b, hits, 4);
+        __m512  thr1 = _mm512_mul_ps(hit_factor, _mm512_mask_i32gather_ps(one, valid, b, luck, 4));
+        __m512  thr2 = _mm512_mul_ps(hit_factor, _mm512_mask_i32gather_ps(one, valid, a, luck, 4));
+        __m512i swings = _mm512_setzero_si512();
+
+        __mmask16 stuck = _mm512_cmp_ps_mask(thr1, one, _CMP_GE_OQ) &
+                          _mm512_cmp_ps_mask(thr2, one, _CMP_GE_OQ);
+        __mmask16 done = _mm512_cmpgt_epi32_mask(h1, ko) | _mm512_cmpgt_epi32_mask(h2, ko) |
+                         stuck | (__mmask16)~valid;
+
+        const int FIRST = (2 * Rules::MAX_HITS_TAKEN - 1 + 3) / 4;
+        __m512 u[4 * FIRST];
+        uniforms16<FIRST>(round, a, 0, ks, u);
+        for (uint32_t block = 0; done != 0xFFFF; ++block) {
+            if (block >= (uint32_t)FIRST) uniforms16<1>(round, a, block, ks, u);
+            const __m512* draws = u + 4 * (block < (uint32_t)FIRST ? block : 0);
+            for (int j = 0; j < 4; ++j) {
+                __mmask16 active = (__mmask16)~done;
+                __mmask16 hit;
+                if (j % 2 == 0) {
+                    hit = _mm512_mask_cmp_ps_mask(active, draws[j], thr1, _CMP_GT_OQ);
+                    h2 = _mm512_mask_add_epi32(h2, hit, h2, inc);
+                } else {
+                    hit = _mm512_mask_cmp_ps_mask(active, draws[j], thr2, _CMP_GT_OQ);
+                    h1 = _mm512_mask_add_epi32(h1, hit, h1, inc);
+                }
+                swings = _mm512_mask_add_epi32(swings, active, swings, inc);
+#ifdef LAB3_STATS
+                attacks += __builtin_popcount(active);
+                landed  += __builtin_popcount(hit);
+#endif
+                done |= _mm512_cmpgt_epi32_mask(h1, ko) | _mm512_cmpgt_epi32_mask(h2, ko);
+            }
+        }
+
+        // fighters of different duels are distinct, so the scatters never collide
+        _mm512_mask_i32scatter_epi32(hits, valid, a, h1, 4);
+        _mm512_mask_i32scatter_epi32(hits, valid, b, h2, 4);
+        __mmask16 p1_alive = _mm512_cmpgt_epi32_mask(_mm512_add_epi32(ko, inc), h1);
+        alignas(64) int win[16], lose[16], sw[16];
+        _mm512_store_si512(win, _mm512_mask_blend_epi32(p1_alive, b, a));
+        _mm512_store_si512(lose, _mm512_mask_blend_epi32(p1_alive, a, b));
+        _mm512_store_si512(sw, swings);
+        for (int k = 0; k < m; ++k) out[base + k] = DuelResult{ win[k], lose[k], sw[k] };
+    }
+    LAB3_COUNT(STAT_DUELS, n);
+    LAB3_COUNT(STAT_ATTACKS, attacks);
+    LAB3_COUNT(STAT_HITS, landed);
+    LAB3_COUNT(STAT_MISSES, attacks - landed);
+    (void)attacks;
+    (void)landed;
+}
+
+#pragma GCC diagnostic pop
+
+enum KernelLevel { KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512 };
+
+// Widest kernel the CPU runs, or a narrower one named by LAB3_DUEL_KERNEL
+// (scalar, avx2) for testing and benchmarking.
+static KernelLevel detectKernel() {
+    KernelLevel level = __builtin_cpu_supports("avx512f") ? KERNEL_AVX512
+                      : __builtin_cpu_supports("avx2")    ? KERNEL_AVX2
+                                                          : KERNEL_SCALAR;
+    const char* want = getenv("LAB3_DUEL_KERNEL");
+    if (want && strcmp(want, "scalar") == 0) level = KERNEL_SCALAR;
+    if (want && strcmp(want, "avx2") == 0 && level > KERNEL_AVX2) level = KERNEL_AVX2;
+    return level;
+}
+
+static KernelLevel kernelLevel() {
+    static const KernelLevel level = detectKernel();
+    return level;
+}
+
+#endif
+
+// ---- dispatch ------------------------------------------------------------
+
+template <class Rules>
+void resolveDuelBatch(PlayerPool& pool, const int* p1, const int* p2, long long n,
+                      uint64_t seed, uint64_t game, uint32_t round, DuelResult* out) {
+#if LAB3_X86
+    switch (kernelLevel()) {
+    case KERNEL_AVX512: avx512Batch<Rules>(pool, p1, p2, n, seed, game, round, out); return;
+    case KERNEL_AVX2:   avx2Batch<Rules>(pool, p1, p2, n, seed, game, round, out);   return;
+    case KERNEL_SCALAR: break;
+    }
+#endif
+    LAB3_COUNT(STAT_DUELS, n);
+    scalarBatch<Rules>(pool, p1, p2, n, seed, game, round, out);
+}
+
+const char* duelKernelName() {
+#if LAB3_X86
+    switch (kernelLevel()) {
+    case KERNEL_AVX512: return "avx512";
+    case KERNEL_AVX2:   return "avx2";
+    case KERNEL_SCALAR: break;
+    }
+#endif
+    return "scalar";
+}
+
+#define LAB3_INSTANTIATE_KERNEL(R)                                                      \
+    template void resolveDuelBatch<R>(PlayerPool&, const int*, const int*, long long, \
+                                      uint64_t, uint64_t, uint32_t, DuelResult*);
+LAB3_FOR_EACH_RULES(LAB3_INSTANTIATE_KERNEL)
@@ -0,0 +1,38 @@
+#ifndef DUELKERNEL_H
+#define DUELKERNEL_H
+
+#include <cstdint>
+#include "Duel.h"
+#include "PlayerPool.h"
+using namespace std;
+
+// Resolves n independent duels at once: p1[i] swings first at p2[i] and
+// they alternate until one is KO'd, exactly as simulateDuel does on
+// CounterRng(seed, game, round, p1[i]). Updates both fighters' hits taken
+// in the pool and writes each duel's result to out[i]. The fighters of
+// different duels must be distinct.
+//
+// On x86 CPUs with AVX-512 or AVX2 (checked at runtime) sixteen or eight
+// duels run side by side; anywhere else each duel takes the scalar loop.
+// LAB3_DUEL_KERNEL=avx2|scalar picks a narrower one. The vector kernels
+// draw each Philox block for all their lanes and convert it to uniforms
+// before the compares that consume it.
+//
+// `./bench --kernels` times each kernel (ns per duel, fresh fighters, luck
+// 0.1 - 3.0). On the Xeon this was written on:
+//   kernel    classic   sudden-death   endurance
+//   scalar     73.5        26.6          203.6
+//   avx2       15.4         8.7           35.8     4.7x / 3.0x / 5.7x
+//   avx512     10.2         6.0           21.4     7.2x / 4.4x / 9.5x
+// AVX2 misses the 8x target. Results must match the scalar stream bit for
+// bit, so every swing costs a Philox4x32-10 draw, and AVX2 has no lane-wise
+// 32-bit multiply-high: the two blocks a classic duel needs at least take
+// about 7 ns of the 9 ns budget before a single compare.
+// Instantiated in DuelKernel.cpp for every rule set.
+template <class Rules>
+void resolveDuelBatch(PlayerPool& pool, const int* p1, const int* p2, long long n,
+                      uint64_t seed, uint64_t game, uint32_t round, DuelResult* out);
+
+const char* duelKernelName();       // "avx512", "avx2" or "scalar", whichever resolveDuelBatch uses
+
+#endif
@@ -0,0 +1,137 @@
+#include "DuelScheduler.h"
+
+#if LAB3_HAVE_COROUTINES
+
+#include <cstdlib>
+#include <new>
+#include "Stats.h"
+using namespace std;
+
+// Recycled coroutine frames. Every duel coroutine of one rule set has the
+// same frame size, so a thread running many duels allocates only its first
+// window's worth.
+namespace {
+struct FrameCache {
+    size_t        size = 0;
+    vector<void*> free;
+
+    ~FrameCache() { for (void* f : free) ::operator delete(f); }
+};
+thread_local FrameCache frame_cache;
+}
+
+void* DuelTask::promise_type::operator new(size_t size) {
+    FrameCache& c = frame_cache;
+    if (size == c.size && !c.free.empty()) {
+        void* f = c.free.back();
+        c.free.pop_back();
+        return f;
+    }
+    return ::operator new(size);
+}
+
+void DuelTask::promise_type::operator delete(void* frame, size_t size) {
+    FrameCache& c = frame_cache;
+    if (c.free.empty()) c.size = size;  // cache whatever size is in use now
+    if (size == c.size) c.free.push_back(frame);
+    else ::operator delete(frame);
+}
+
+// The swing loop of simulateDuel, suspended after every swing. The stream
+// parameter is only there for the promise, which draws the rolls from it.
+template <class Rules>
+static DuelTask duelTask(BasicRPG<Rules> p1, BasicRPG<Rules> p2, CounterRng) {
+    typedef DuelTask::promise_type::NextRoll NextRoll;
+    int swings = 0;
+    while (p1.isAlive() && p2.isAlive()) {
+        int before = p2.getHitsTaken();
+        p1.attack(p2, co_await NextRoll{});
+        ++swings;
+        co_yield SwingEvent{ p1.getId(), p2.getId(), p2.getHitsTaken() != before };
+        if (!p2.isAlive()) break;
+        before = p1.getHitsTaken();
+        p2.attack(p1, co_await NextRoll{});
+        ++swings;
+        co_yield SwingEvent{ p2.getId(), p1.getId(), p1.getHitsTaken() != before };
+    }
+    if (p1.isAlive()) co_return DuelResult{ p1.getId(), p2.getId(), swings };
+    co_return DuelResult{ p2.getId(), p1.getId(), swings };
+}
+
+template <class Rules>
+DuelScheduler<Rules>::DuelScheduler(int w)
+    : window(w < 1 ? 1 : w), next_queued(0), record(false) {
+    active.reserve(window);
+}
+
+template <class Rules>
+DuelScheduler<Rules>::~DuelScheduler() { clear(); }
+
+template <class Rules>
+void DuelScheduler<Rules>::clear() {
+    for (Handle h : active) h.destroy();
+    active.clear();
+    queued.clear();
+    next_queued = 0;
+    done.clear();
+    step_swings.clear();
+}
+
+template <class Rules>
+void DuelScheduler<Rules>::add(Player p1, Player p2, const CounterRng& rng) {
+    queued.push_back({ p1, p2, rng });
+    done.push_back({ -1, -1, 0 });
+}
+
+template <class Rules>
+void DuelScheduler<Rules>::admit() {
+    while ((int)active.size() < window && next_queued < queued.size()) {
+        const Pending& d = queued[next_queued];
+        Handle h = duelTask<Rules>(d.p1, d.p2, d.rng).release();
+        h.promise().index = (int)next_queued++;
+        active.push_back(h);
+        LAB3_COUNT(STAT_DUELS, 1);
+    }
+}
+
+template <class Rules>
+bool DuelScheduler<Rules>::step() {
+    admit();
+    step_swings.clear();
+    if (active.empty()) return false;
+
+    // pass 1: batch the random draws, eight rolls per duel that ran dry
+    for (Handle h : active) {
+        DuelTask::promise_type& p = h.promise();
+        if (p.used == DuelTask::ROLLS) {
+            p.rng->fillUniform(p.rolls, DuelTask::ROLLS);
+            p.used = 0;
+        }
+    }
+
+    // pass 2: one swing each; finished duels are swap-removed from the window
+    for (size_t i = 0; i < active.size();) {
+        Handle h = active[i];
+        h.resume();
+        if (h.done()) {
+            done[h.promise().index] = h.promise().result;
+            h.destroy();
+            active[i] = active.back();
+            active.pop_back();
+            continue;
+        }
+        if (record) step_swings.push_back(h.promise().swing);
+        ++i;
+    }
+    return true;
+}
+
+template <class Rules>
+void DuelScheduler<Rules>::run() {
+    while (step()) {}
+}
+
+#define LAB3_INSTANTIATE_SCHEDULER(R) template class DuelScheduler<R>;
+LAB3_FOR_EACH_RULES(LAB3_INSTANTIATE_SCHEDULER)
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef DUELSCHEDULER_H
+#define DUELSCHEDULER_H
+
+// Interleaved duels: every duel is a C++20 coroutine that suspends after each
+// swing, and a scheduler keeps a window of them in flight, advancing each by
+// one swing per step. Needs -std=c++20; without coroutine support this header
+// only defines LAB3_HAVE_COROUTINES as 0 and Game falls back to the swing loop.
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define LAB3_HAVE_COROUTINES 1
+#else
+#define LAB3_HAVE_COROUTINES 0
+#endif
+
+#if LAB3_HAVE_COROUTINES
+
+#include <coroutine>
+#include <vector>
+#include "CounterRng.h"
+#include "Duel.h"
+#include "RPG.h"
+using namespace std;
+
+// one swing, as yielded by a duel
+struct SwingEvent {
+    int  attacker;                  // pool index
+    int  defender;                  // pool index
+    bool hit;
+};
+
+// Handle to one suspended duel. Rolls are drawn ROLLS at a time from the
+// duel's own CounterRng, so a duel sees exactly the values simulateDuel
+// would draw from the same stream and ends the same way.
+class DuelTask {
+public:
+    static const int ROLLS = 8;
+
+    struct promise_type {
+        // the coroutine's parameters are (p1, p2, rng); keep the frame's copy of rng
+        template <class P>
+        promise_type(P&, P&, CounterRng& r) : rng(&r) {}
+
+        DuelTask get_return_object() {
+            return DuelTask(coroutine_handle<promise_type>::from_promise(*this));
+        }
+        suspend_always initial_suspend() noexcept { return {}; }
+        suspend_always final_suspend() noexcept { return {}; }
+        suspend_always yield_value(SwingEvent e) { swing = e; return {}; }
+        void return_value(DuelResult r) { result = r; }
+        void unhandled_exception() { throw; }
+
+        // co_await NextRoll{} takes the next buffered roll without suspending
+        struct NextRoll {};
+        struct RollAwaiter {
+            promise_type& p;
+            bool  await_ready() const noexcept { return true; }
+            void  await_suspend(coroutine_handle<>) const noexcept {}
+            float await_resume() noexcept { return p.rolls[p.used++]; }
+        };
+        RollAwaiter await_transform(NextRoll) { return { *this }; }
+
+        // frames come from a per-thread free list, duel frames are all one size
+        static void* operator new(size_t size);
+        static void  operator delete(void* frame, size_t size);
+
+        CounterRng* rng;            // lives in the coroutine frame
+        float       rolls[ROLLS];
+        int         used = ROLLS;   // refilled by the scheduler between steps
+        SwingEvent  swing;          // last yielded
+        DuelResult  result;
+        int         index = 0;      // add() order, for DuelScheduler::results()
+    };
+
+    DuelTask(DuelTask&& other) noexcept : h(other.h) { other.h = nullptr; }
+    ~DuelTask() { if (h) h.destroy(); }
+
+    coroutine_handle<promise_type> release() { auto r = h; h = nullptr; return r; }
+
+private:
+    explicit DuelTask(coroutine_handle<promise_type> handle) : h(handle) {}
+
+    coroutine_handle<promise_type> h;
+};
+
+// Runs many independent duels together. Each step() is two flat passes over
+// the in-flight window: one refills every duel that has used up its rolls,
+// then one resumes every duel for exactly one swing. The swings of a step
+// are collected in swings() instead of being reported through a callback.
+// Instantiated in DuelScheduler.cpp for every rule set.
+template <class Rules>
+class DuelScheduler {
+public:
+    typedef BasicRPG<Rules> Player;
+
+    explicit DuelScheduler(int window = 256); // duels in flight at once
+    ~DuelScheduler();
+    DuelScheduler(const DuelScheduler&) = delete;
+    DuelScheduler& operator=(const DuelScheduler&) = delete;
+
+    void add(Player p1, Player p2, const CounterRng& rng); // queue a duel, p1 swings first
+    bool step();                    // one swing for every duel in flight; false when all are done
+    void run();                     // step() until every queued duel is decided
+    void clear();                   // drop queued, running and finished duels
+
+    void recordSwings(bool on) { record = on; } // off by default
+    const vector<SwingEvent>& swings() const { return step_swings; } // the last step's, if recording
+    const vector<DuelResult>& results() const { return done; }       // in add() order
+    int  inFlight() const { return (int)active.size(); }
+
+private:
+    typedef coroutine_handle<DuelTask::promise_type> Handle;
+
+    struct Pending {
+        Player     p1, p2;
+        CounterRng rng;
+    };
+
+    void admit();                   // start queued duels in free window slots
+
+    int                window;
+    vector<Pending>    queued;      // frames are only made once a slot is free
+    size_t             next_queued;
+    vector<Handle>     active;
+    vector<DuelResult> done;
+    vector<SwingEvent> step_swings;
+    bool               record;
+};
+
+#endif
+
+#endif
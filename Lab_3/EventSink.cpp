@@ -0,0 +1,234 @@
+#include "EventSink.h"
+#include <charconv>
+#include <chrono>
+#include <cstring>
+using namespace std;
+
+BufferedSink::BufferedSink(FILE* o, size_t bytes)
+    : out(o), capacity(bytes), stopping(false) {
+    active.reserve(capacity);
+    pending.reserve(capacity);
+    writer = thread(&BufferedSink::writerLoop, this);
+}
+
+BufferedSink::~BufferedSink() {
+    flush();
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+}
+
+void BufferedSink::writerLoop() {
+    unique_lock<mutex> guard(lock);
+    for (;;) {
+        wake.wait(guard, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) return;    // stopping with nothing left
+        guard.unlock();
+        fwrite(pending.data(), 1, pending.size(), out);
+        fflush(out);
+        guard.lock();
+        pending.clear();
+        wake.notify_all();
+    }
+}
+
+void BufferedSink::handOff() {
+    if (active.empty()) return;
+    unique_lock<mutex> guard(lock);
+    wake.wait(guard, [this] { return pending.empty(); });
+    active.swap(pending);
+    wake.notify_all();
+}
+
+void BufferedSink::flush() {
+    handOff();
+    unique_lock<mutex> guard(lock);
+    wake.wait(guard, [this] { return pending.empty(); });
+}
+
+void BufferedSink::reserveRoom(size_t bytes) {
+    if (active.size() + bytes > capacity) handOff();
+}
+
+static void appendText(string& buf, const char* s) { buf.append(s, strlen(s)); }
+
+static void appendNumber(string& buf, long long v) {
+    char tmp[24];
+    char* end = to_chars(tmp, tmp + sizeof tmp, v).ptr;
+    buf.append(tmp, end - tmp);
+}
+
+// same digits cout gives a float by default (%g, 6 significant)
+static void appendNumber(string& buf, float v) {
+    char tmp[32];
+    char* end = to_chars(tmp, tmp + sizeof tmp, v, chars_format::general, 6).ptr;
+    buf.append(tmp, end - tmp);
+}
+
+static void appendElimination(string& buf, const PlayerPool& pool, int winner, int loser) {
+    pool.appendName(buf, winner);
+    appendText(buf, " won against ");
+    pool.appendName(buf, loser);
+    appendText(buf, "\n\n");
+}
+
+// matches RPG::printStats; the stats are passed in so a queued row keeps
+// the values it had when it was pushed
+static void appendStats(string& buf, const PlayerPool& pool, int id, int hits, float luck, float exp,
+                        int level, bool alive) {
+    appendText(buf, "Name: ");
+    pool.appendName(buf, id);
+    appendText(buf, "   Hits Taken: ");
+    appendNumber(buf, (long long)hits);
+    appendText(buf, "   Luck: ");
+    appendNumber(buf, luck);
+    appendText(buf, "   Exp: ");
+    appendNumber(buf, exp);
+    appendText(buf, "   Level: ");
+    appendNumber(buf, (long long)level);
+    appendText(buf, "   Status: ");
+    appendText(buf, alive ? "Alive" : "Dead");
+    buf.push_back('\n');
+}
+
+void BufferedSink::elimination(long long, const PlayerPool& pool, int winner, int loser) {
+    reserveRoom(128);
+    appendElimination(active, pool, winner, loser);
+}
+
+void BufferedSink::playerStats(const PlayerPool& pool, int id, bool alive) {
+    reserveRoom(160);
+    appendStats(active, pool, id, pool.hitsTaken(id), pool.luckOf(id), pool.expOf(id), pool.levelOf(id), alive);
+}
+
+// ---- QueuedSink ---------------------------------------------------------------
+
+static const size_t LOG_WRITE_BYTES = 1 << 20;
+
+// spin a little, then give the core away, then sleep
+static void backOff(int& idle) {
+    if (++idle < 64) return;
+    if (idle < 128) this_thread::yield();
+    else this_thread::sleep_for(chrono::microseconds(50));
+}
+
+static size_t roundUpPow2(size_t n) {
+    size_t p = 2;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+QueuedSink::QueuedSink(FILE* o, Backpressure p, size_t slots, long long k)
+    : out(o), policy(p), sample_every(k < 1 ? 1 : k), mask(roundUpPow2(slots) - 1),
+      ring(new Slot[mask + 1]), tail(0), written(0), dropped_events(0), stopping(false) {
+    for (size_t i = 0; i <= mask; ++i) ring[i].seq.store(i, memory_order_relaxed);
+    logger = thread(&QueuedSink::loggerLoop, this);
+}
+
+QueuedSink::~QueuedSink() {
+    flush();
+    stopping.store(true, memory_order_release);
+    logger.join();
+}
+
+// Vyukov's bounded queue, producer side: a slot whose seq equals the
+// position is free; claim the position, fill the slot, then publish it.
+bool QueuedSink::tryPush(const Event& e) {
+    uint64_t pos = tail.load(memory_order_relaxed);
+    for (;;) {
+        Slot& slot = ring[pos & mask];
+        uint64_t seq = slot.seq.load(memory_order_acquire);
+        if (seq == pos) {
+            if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                slot.event = e;
+                slot.seq.store(pos + 1, memory_order_release);
+                return true;
+            }
+        } else if (seq < pos) {
+            return false;           // a lap behind: the ring is full
+        } else {
+            pos = tail.load(memory_order_relaxed);
+        }
+    }
+}
+
+void QueuedSink::push(const Event& e) {
+    for (int idle = 0; !tryPush(e);) backOff(idle);
+}
+
+void QueuedSink::elimination(long long round, const PlayerPool& pool, int winner, int loser) {
+    Event e = { &pool, round, winner, loser, 0, 0.0f, 0.0f, 0, false };
+    if (tryPush(e)) return;
+    if (policy == Backpressure::Block || (policy == Backpressure::Sample && round % sample_every == 0)) {
+        push(e);
+    } else {
+        dropped_events.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+void QueuedSink::playerStats(const PlayerPool& pool, int id, bool alive) {
+    push({ &pool, 0, id, -1, pool.hitsTaken(id), pool.luckOf(id), pool.expOf(id), pool.levelOf(id), alive });
+}
+
+void QueuedSink::flush() {
+    uint64_t target = tail.load(memory_order_acquire);
+    for (int idle = 0; written.load(memory_order_acquire) < target;) backOff(idle);
+}
+
+// The single consumer: no compare-exchange, it owns the head. Whenever the
+// ring runs dry it writes what it has and publishes how far it got.
+void QueuedSink::loggerLoop() {
+    string buf;
+    buf.reserve(LOG_WRITE_BYTES + 256);
+    uint64_t head = 0;
+    int idle = 0;
+    for (;;) {
+        Slot& slot = ring[head & mask];
+        if (slot.seq.load(memory_order_acquire) == head + 1) {
+            Event e = slot.event;
+            slot.seq.store(head + mask + 1, memory_order_release); // free for the next lap
+            ++head;
+            if (e.loser >= 0) appendElimination(buf, *e.pool, e.id, e.loser);
+            else appendStats(buf, *e.pool, e.id, e.hits, e.luck, e.exp, e.level, e.alive);
+            if (buf.size() >= LOG_WRITE_BYTES) {
+                fwrite(buf.data(), 1, buf.size(), out);
+                buf.clear();
+            }
+            idle = 0;
+            continue;
+        }
+        if (!buf.empty()) {
+            fwrite(buf.data(), 1, buf.size(), out);
+            fflush(out);
+            buf.clear();
+        }
+        written.store(head, memory_order_release);
+        if (stopping.load(memory_order_acquire) && tail.load(memory_order_acquire) == head) return;
+        backOff(idle);
+    }
+}
+
+SampledSink::SampledSink(EventSink& in, long long k)
+    : inner(in), every(k < 1 ? 1 : k) {}
+
+void SampledSink::elimination(long long round, const PlayerPool& pool, int winner, int loser) {
+    if (round % every == 0) inner.elimination(round, pool, winner, loser);
+}
+
+void SampledSink::playerStats(const PlayerPool& pool, int id, bool alive) {
+    inner.playerStats(pool, id, alive);
+}
+void SampledSink::flush() { inner.flush(); }
+
+EventSink& stdoutSink() {
+    static BufferedSink sink(stdout);
+    return sink;
+}
+
+EventSink& silentSink() {
+    static SilentSink sink;
+    return sink;
+}
@@ -0,0 +1,135 @@
+#ifndef EVENTSINK_H
+#define EVENTSINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "PlayerPool.h"
+using namespace std;
+
+// Where Game sends its per-round and final output. Players are passed as
+// pool rows rather than RPG handles so one sink serves every rule set.
+class EventSink {
+public:
+    virtual ~EventSink() {}
+
+    virtual void elimination(long long round, const PlayerPool& pool, int winner, int loser) = 0;
+    virtual void playerStats(const PlayerPool& pool, int id, bool alive) = 0; // one printFinalResults row
+    virtual void flush() {}                      // everything so far is written
+};
+
+// Formats events into a large in-memory buffer; a background thread writes
+// full buffers out, so the simulation never waits on the terminal or disk.
+// One producer thread at a time.
+class BufferedSink : public EventSink {
+public:
+    explicit BufferedSink(FILE* out, size_t buffer_bytes = 4 << 20);
+    ~BufferedSink();
+
+    void elimination(long long round, const PlayerPool& pool, int winner, int loser) override;
+    void playerStats(const PlayerPool& pool, int id, bool alive) override;
+    void flush() override;
+
+private:
+    void reserveRoom(size_t bytes);
+    void handOff();                 // give the active buffer to the writer
+    void writerLoop();
+
+    FILE*              out;
+    size_t             capacity;
+    string             active;      // being filled by the producer
+    string             pending;     // being written by the writer
+    mutex              lock;
+    condition_variable wake;
+    bool               stopping;
+    thread             writer;
+};
+
+// What QueuedSink does with an elimination that finds its ring full.
+// Final stats rows always wait for room, so the table is never cut short.
+enum class Backpressure {
+    Drop,         // lose it (counted in dropped())
+    Block,        // wait for the logger to make room (default)
+    Sample        // keep only every k-th round, waiting for those; lose the rest
+};
+
+// Bounded lock-free ring for any number of producer threads and one
+// logger thread. Producers claim a slot with one compare-exchange and copy
+// a small fixed record in (ids and the row's stats, no text); the logger
+// formats records the way BufferedSink does and writes about a megabyte at
+// a time. Names are read from the pool when the logger formats them, so a
+// pool must not be renamed or freed before flush().
+class QueuedSink : public EventSink {
+public:
+    explicit QueuedSink(FILE* out, Backpressure policy = Backpressure::Block,
+                        size_t slots = 1 << 16, long long sample_every = 64);
+    ~QueuedSink();
+
+    void elimination(long long round, const PlayerPool& pool, int winner, int loser) override;
+    void playerStats(const PlayerPool& pool, int id, bool alive) override;
+    void flush() override;          // waits until the logger has written everything pushed so far
+    long long dropped() const { return dropped_events.load(memory_order_relaxed); }
+
+private:
+    struct Event {
+        const PlayerPool* pool;
+        long long         round;
+        int               id;       // winner, or the stats row
+        int               loser;    // -1 for a stats row
+        int               hits;
+        float             luck;
+        float             exp;
+        int               level;
+        bool              alive;
+    };
+    struct alignas(64) Slot {       // one per line, so neighbouring producers never share
+        atomic<uint64_t> seq;       // == position: free; == position + 1: holds an event
+        Event            event;
+    };
+
+    bool tryPush(const Event& e);
+    void push(const Event& e);      // waits for room
+    void loggerLoop();
+
+    FILE*             out;
+    Backpressure      policy;
+    long long         sample_every;
+    size_t            mask;         // slots - 1, slots a power of two
+    unique_ptr<Slot[]> ring;
+    alignas(64) atomic<uint64_t> tail; // next position to claim
+    alignas(64) atomic<uint64_t> written; // positions before it are formatted and written
+    atomic<long long> dropped_events;
+    atomic<bool>      stopping;
+    thread            logger;
+};
+
+// Drops everything.
+class SilentSink : public EventSink {
+public:
+    void elimination(long long, const PlayerPool&, int, int) override {}
+    void playerStats(const PlayerPool&, int, bool) override {}
+};
+
+// Forwards eliminations from every k-th round only; final stats pass through.
+class SampledSink : public EventSink {
+public:
+    SampledSink(EventSink& inner, long long every_k_rounds);
+
+    void elimination(long long round, const PlayerPool& pool, int winner, int loser) override;
+    void playerStats(const PlayerPool& pool, int id, bool alive) override;
+    void flush() override;
+
+private:
+    EventSink& inner;
+    long long  every;
+};
+
+EventSink& stdoutSink();            // process-wide BufferedSink on stdout, the Game default
+EventSink& silentSink();
+
+#endif
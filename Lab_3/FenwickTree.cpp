@@ -0,0 +1,81 @@
+#include "FenwickTree.h"
+using namespace std;
+
+void FenwickTree::build(const vector<double>& weights) {
+    weight = weights;
+    rebuild();
+}
+
+void FenwickTree::clear() {
+    weight.clear();
+    tree.clear();
+    sum = 0.0;
+    top_bit = 0;
+    updates = 0;
+}
+
+// O(n): every node passes its partial sum up to its parent once
+void FenwickTree::rebuild() {
+    int n = (int)weight.size();
+    tree.assign(n + 1, 0.0);
+    sum = 0.0;
+    for (int i = 1; i <= n; ++i) {
+        tree[i] += weight[i - 1];
+        sum += weight[i - 1];
+        int parent = i + (i & -i);
+        if (parent <= n) tree[parent] += tree[i];
+    }
+    top_bit = 1;
+    while (top_bit * 2 <= n) top_bit *= 2;
+    if (n == 0) top_bit = 0;
+    updates = 0;
+}
+
+void FenwickTree::set(int i, double w) {
+    double delta = w - weight[i];
+    if (delta == 0.0) return;
+    weight[i] = w;
+    if (++updates > (long long)weight.size()) {
+        rebuild();
+        return;
+    }
+    sum += delta;
+    for (int k = i + 1; k < (int)tree.size(); k += k & -k) tree[k] += delta;
+}
+
+// The sums are saved rather than rebuilt on load: a rebuild rounds
+// differently from the deltas applied since, and a boundary draw could
+// then pick a different entry than the uninterrupted run.
+void FenwickTree::save(CheckpointWriter& out) const {
+    out.value(sum);
+    out.value(top_bit);
+    out.value(updates);
+    out.column(weight);
+    out.column(tree);
+}
+
+void FenwickTree::load(CheckpointReader& in) {
+    clear();
+    in.value(sum);
+    in.value(top_bit);
+    in.value(updates);
+    in.column(weight);
+    in.column(tree);
+    if (!in.ok() || tree.size() != weight.size() + 1) clear();
+}
+
+int FenwickTree::sample(double u) const {
+    // walk down from the top bit, skipping every subtree whose sum is <= u
+    int pos = 0;
+    for (int step = top_bit; step > 0; step >>= 1) {
+        int next = pos + step;
+        if (next < (int)tree.size() && tree[next] <= u) {
+            pos = next;
+            u -= tree[next];
+        }
+    }
+    // pos is now the 0-based entry; rounding at a boundary can land past
+    // the end or on a zero-weight neighbour
+    if (pos >= (int)weight.size() || weight[pos] <= 0.0) return -1;
+    return pos;
+}
@@ -0,0 +1,39 @@
+#ifndef FENWICKTREE_H
+#define FENWICKTREE_H
+
+#include <vector>
+#include "Checkpoint.h"
+using namespace std;
+
+// Binary indexed tree over non-negative weights, for sampling an index with
+// probability weight / total. set() and sample() are O(log n), build() is
+// O(n). Weight changes are applied as deltas, so rounding error would pile
+// up over millions of updates; the tree rebuilds itself from the exact
+// weights once the updates since the last build outnumber the entries.
+class FenwickTree {
+public:
+    void   build(const vector<double>& weights); // replaces every weight
+    void   set(int i, double w);    // weight of entry i
+    double get(int i) const { return weight[i]; }
+    double total() const { return sum; }
+    int    size() const { return (int)weight.size(); }
+    void   clear();
+    void   save(CheckpointWriter& out) const; // partial sums as they are, rounding and all
+    void   load(CheckpointReader& in);
+
+    // Entry whose weight covers u in [0, total()), i.e. the first i with
+    // prefix(i) > u. Only entries with positive weight are returned; -1
+    // (draw u again) in the rare case rounding lands on a boundary.
+    int    sample(double u) const;
+
+private:
+    void rebuild();
+
+    vector<double> weight;          // exact weights
+    vector<double> tree;            // 1-based partial sums
+    double         sum = 0.0;
+    int            top_bit = 0;     // highest power of two <= size
+    long long      updates = 0;     // set() calls since the last rebuild
+};
+
+#endif
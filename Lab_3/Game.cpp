@@ -1,76 +1,571 @@
 #include "Game.h"
+#include <algorithm>
 #include <iostream>
-#include <random>
+#include <sstream>
+#include "DuelKernel.h"
+#include "DuelScheduler.h"
+#include "Parallel.h"
+#include "Stats.h"
 using namespace std;
 
-static mt19937 GRNG(random_device{}());
+template <class Rules>
+BasicGame<Rules>::BasicGame() : BasicGame(random_device{}()) {}
 
-Game::Game() {}
+template <class Rules>
+BasicGame<Rules>::BasicGame(uint64_t s)
+    : liveness(Liveness::Packed), seed(s), game_id(0), duel_mode(DuelMode::Analytic),
+      matchmaking(Matchmaking::Uniform), weights_stale(true),
+      sink(&stdoutSink()), trace(nullptr), report_stats(true), round(0), loop(Loop::None),
+      checkpoint_every(0) {
+    seedEngine(rng, s);
+}
+
+template <class Rules>
+void BasicGame<Rules>::reset(uint64_t s) {
+    players.clear();
+    live_players.clear();
+    live_pos.clear();
+    live_bits.clear();
+    weights.clear();
+    weights_stale = true;
+    seed = s;
+    seedEngine(rng, s);
+    round = 0;
+    loop = Loop::None;
+}
+
+template <class Rules>
+void BasicGame<Rules>::reserve(int n) {
+    players.reserve(n);
+    if (liveness == Liveness::Packed) {
+        live_players.reserve(n);
+        live_pos.reserve(n);
+        bracket_winners.reserve(n / 2);
+    }
+}
+
+template <class Rules> void     BasicGame<Rules>::setDuelMode(DuelMode mode) { duel_mode = mode; }
+template <class Rules> void     BasicGame<Rules>::setMatchmaking(Matchmaking m) {
+    matchmaking = m;
+    weights_stale = true;
+}
+template <class Rules> void     BasicGame<Rules>::setLiveness(Liveness l) { liveness = l; }
+template <class Rules> void     BasicGame<Rules>::setEventSink(EventSink& s) { sink = &s; }
+template <class Rules> void     BasicGame<Rules>::setGameId(uint64_t id) { game_id = id; }
+template <class Rules> void     BasicGame<Rules>::setReportStats(bool on) { report_stats = on; }
+template <class Rules> void     BasicGame<Rules>::setTrace(TraceWriter* t) { trace = t; }
+template <class Rules> void     BasicGame<Rules>::setCheckpoint(const string& path, long long every) {
+    checkpoint_path = path;
+    checkpoint_every = every;
+}
+template <class Rules> uint64_t BasicGame<Rules>::getSeed() const { return seed; }
+template <class Rules> typename BasicGame<Rules>::Player BasicGame<Rules>::getPlayer(int index) {
+    return Player(&players, index);
+}
+template <class Rules> int      BasicGame<Rules>::getNumPlayers() const { return players.size(); }
+template <class Rules> int      BasicGame<Rules>::getNumAlive() const {
+    return liveness == Liveness::Bitset ? live_bits.count() : (int)live_players.size();
+}
+template <class Rules> int      BasicGame<Rules>::getChampion() const {
+    if (getNumAlive() != 1) return -1;
+    return liveness == Liveness::Bitset ? live_bits.next(0) : live_players[0];
+}
+template <class Rules> bool     BasicGame<Rules>::isLive(int index) const {
+    return liveness == Liveness::Bitset ? live_bits.test(index) : live_pos[index] >= 0;
+}
+template <class Rules> long long BasicGame<Rules>::getRound() const { return round; }
 
-void Game::generatePlayers(int n) {
+template <class Rules>
+void BasicGame<Rules>::generatePlayers(int n) {
+    reserve(players.size() + n);
+    if (liveness == Liveness::Bitset) {
+        for (int i = 0; i < n; ++i) players.add();
+        live_bits.grow(n);
+        weights_stale = true;
+        return;
+    }
     for ( int i = 0; i < n; ++i) {
-        players.push_back(new RPG());
+        // named NPC_<index> implicitly, nothing is formatted until printed
+        int id = players.add();
+        live_pos.push_back(live_players.size());
+        live_players.push_back(id);
+    }
+    weights_stale = true;
+}
+
+template <class Rules>
+bool BasicGame<Rules>::loadPlayers(const string& path, string* error, int threads) {
+    int first = players.size();
+    RosterLoader loader(threads);
+    if (!loader.load(players, path)) {
+        if (error) *error = loader.error();
+        return false;
+    }
+    reserve(players.size());
+    enlist(first, players.size() - first);
+    return true;
+}
+
+template <class Rules>
+int BasicGame<Rules>::addPlayer(const string& name, int hits_taken, float luck, float exp, int level) {
+    int id = players.add(name, hits_taken, luck, exp, level);
+    enlist(id, 1);
+    return id;
+}
 
-        string new_name = "NPC_" + to_string(i);
-        players[i]->setName(new_name);
-        live_players.insert(i);
+// Players added with their own stats join like generated ones, except that
+// one already at MAX_HITS_TAKEN (a dead player in an exported table) starts
+// eliminated.
+template <class Rules>
+void BasicGame<Rules>::enlist(int first, int n) {
+    weights_stale = true;
+    if (liveness == Liveness::Bitset) {
+        live_bits.grow(n);
+        for (int i = first; i < first + n; ++i) {
+            if (players.hitsTaken(i) >= Rules::MAX_HITS_TAKEN) live_bits.remove(i);
+        }
+        return;
+    }
+    for (int i = first; i < first + n; ++i) {
+        if (players.hitsTaken(i) >= Rules::MAX_HITS_TAKEN) {
+            live_pos.push_back(-1);
+        } else {
+            live_pos.push_back(live_players.size());
+            live_players.push_back(i);
+        }
     }
 }
 
-int Game::selectPlayer() {
-random_device rd;
-mt19937 gen(rd());
-uniform_int_distribution<> dis(0, live_players.size() - 1);
+template <class Rules>
+int BasicGame<Rules>::selectPlayer() {
+    if (matchmaking != Matchmaking::Uniform) return selectWeighted(-1);
+    if (liveness == Liveness::Bitset) return live_bits.sample(rng);
+    uniform_int_distribution<> dis(0, live_players.size() - 1);
+    int rand_index = dis(rng);
 
-int rand_index = dis(gen);
+    // packed array, so the pick is a direct lookup
+    return live_players[rand_index];
+}
+
+template <class Rules>
+double BasicGame<Rules>::weightOf(int index) const {
+    if (!isLive(index)) return 0.0;
+    double w = (matchmaking == Matchmaking::ByLevel) ? (double)players.levelOf(index)
+                                                     : (double)players.luckOf(index);
+    return max(w, 1e-6);            // a custom 0-luck player can still be drawn
+}
+
+template <class Rules>
+void BasicGame<Rules>::reweigh(int index) {
+    if (matchmaking != Matchmaking::Uniform && !weights_stale) weights.set(index, weightOf(index));
+}
 
-    set<int>::iterator it = live_players.begin(); 
-    advance(it, rand_index);
-    int selected_index = *it; 
-    return selected_index;
+// Weighted pick over every pool index (eliminated ones weigh 0), never
+// `exclude`. A few plain redraws usually suffice; if `exclude` holds most of
+// the weight it is taken out of the tree for the draw instead.
+template <class Rules>
+int BasicGame<Rules>::selectWeighted(int exclude) {
+    if (weights_stale) {
+        // once per generatePlayers / bracketRound / mode change, O(n)
+        vector<double> w(players.size());
+        for (int i = 0; i < players.size(); ++i) w[i] = weightOf(i);
+        weights.build(w);
+        weights_stale = false;
+    }
+    for (int tries = 0; exclude < 0 || tries < 4; ++tries) {
+        int pick = weights.sample(uniform_real_distribution<double>(0.0, weights.total())(rng));
+        if (pick >= 0 && pick != exclude) return pick;
+        if (pick >= 0) LAB3_COUNT(STAT_SELECT_RETRIES, 1);
+    }
+    double saved = weights.get(exclude);
+    weights.set(exclude, 0.0);
+    int pick = -1;
+    while (pick < 0) {
+        pick = weights.sample(uniform_real_distribution<double>(0.0, weights.total())(rng));
+    }
+    weights.set(exclude, saved);
+    return pick;
 }
 
-void Game::endRound(RPG* winner, RPG* loser, int loserIndex) {
-    winner->setHitsTaken(0);
-    live_players.erase(loserIndex);
-    winner->updateExpLevel();
-    cout << winner->getName() << " won against " << loser->getName() << "\n\n";
+template <class Rules>
+void BasicGame<Rules>::endRound(Player winner, Player loser, int loserIndex) {
+    LAB3_PHASE(PHASE_REPORTING);
+    winner.setHitsTaken(0);
+    int level_before = winner.getLevel();
+    if (liveness == Liveness::Bitset) {
+        live_bits.remove(loserIndex);
+    } else {
+        // swap-remove: move the last alive index into the loser's slot
+        int slot = live_pos[loserIndex];
+        int last = live_players.back();
+        live_players[slot] = last;
+        live_pos[last] = slot;
+        live_players.pop_back();
+        live_pos[loserIndex] = -1;
+    }
+    winner.updateExpLevel();
+    reweigh(loserIndex);            // now 0
+    reweigh(winner.getId());        // level or luck may have gone up
+    if (trace) {
+        trace->result(round, winner.getId(), loser.getId(), winner.getExp(),
+                      winner.getLevel() - level_before);
+    }
+    sink->elimination(round, players, winner.getId(), loser.getId());
 }
 
-void Game::battleRound() {
+template <class Rules>
+void BasicGame<Rules>::battleRound() {
     // ensure two different fighters
-    int idx1 = selectPlayer();
-    int idx2 = selectPlayer();
-    while (idx2 == idx1) {
-        idx2 = selectPlayer();
+    int idx1, idx2;
+    {
+        LAB3_PHASE(PHASE_SELECTION);
+        idx1 = selectPlayer();
+        if (matchmaking != Matchmaking::Uniform) {
+            idx2 = selectWeighted(idx1);
+        } else {
+            idx2 = selectPlayer();
+            while (idx2 == idx1) {
+                LAB3_COUNT(STAT_SELECT_RETRIES, 1);
+                idx2 = selectPlayer();
+            }
+        }
     }
 
-    RPG* p1 = players[idx1];
-    RPG* p2 = players[idx2];
+    Player p1(&players, idx1);
+    Player p2(&players, idx2);
 
     // alternate attacks until one is KO'd
-    while (p1->isAlive() && p2->isAlive()) {
-        p1->attack(p2);
-        if (!p2->isAlive()) break;
-        p2->attack(p1);
+    DuelResult r;
+    {
+        LAB3_PHASE(PHASE_COMBAT);
+        r = fight(p1, p2);
     }
+    ++round;
 
-    if (p1->isAlive()) {
-        endRound(p1, p2, idx2);
-    } else {
-        endRound(p2, p1, idx1);
+    endRound(Player(&players, r.winner), Player(&players, r.loser), r.loser);
+}
+
+// forwards the swings of one duel to the trace
+class TraceSwings : public SwingObserver {
+public:
+    TraceSwings(TraceWriter* t, long long r) : trace(t), round(r) {}
+    void swing(int attacker, int defender, bool hit) override {
+        trace->swing(round, attacker, defender, hit);
     }
+
+private:
+    TraceWriter* trace;
+    long long    round;
+};
+
+// Every duel draws from its own counter-based stream, so it can be replayed
+// on any thread, in any order, from (seed, game id, round, first fighter).
+template <class Rules>
+DuelResult BasicGame<Rules>::fight(Player p1, Player p2) const {
+    LAB3_COUNT(STAT_DUELS, 1);
+    CounterRng engine(seed, game_id, (uint32_t)round, (uint32_t)p1.getId());
+    if (trace) {
+        // a trace needs every swing, so it always takes the swing loop
+        TraceSwings watch(trace, round + 1);
+        return simulateDuel(p1, p2, engine, &watch);
+    }
+    // one duel at a time has nothing to interleave or batch with, so
+    // Interleaved and Batched take the swing loop they are equivalent to
+    return (duel_mode == DuelMode::Analytic) ? resolveDuel(p1, p2, engine)
+                                             : simulateDuel(p1, p2, engine);
+}
+
+template <class Rules>
+void BasicGame<Rules>::bracketRound(int threads) {
+    // Fixed bracket: neighbouring slots meet, so winners of adjacent matches
+    // meet next round and every round walks the pool in order. With an odd
+    // count a random slot sits the round out.
+    if (liveness == Liveness::Bitset) {
+        bracketRoundBits(threads);
+        return;
+    }
+    long long alive = live_players.size();
+    long long bye = (alive % 2 == 1) ? uniform_int_distribution<long long>(0, alive - 1)(rng) : alive;
+    long long pairs = alive / 2;
+    bracket_winners.resize(pairs);
+    auto slot = [bye](long long k) { return k < bye ? k : k + 1; };
+
+    // Duels are disjoint, so they only write their own two rows. Chunks are
+    // claimed dynamically since duel lengths vary; every duel has its own
+    // keyed stream, so the result does not depend on the thread count.
+    const long long chunk = 256;
+    if (trace) threads = 1;             // the trace writer is single-threaded
+    {
+        LAB3_PHASE(PHASE_COMBAT);
+        if (duel_mode == DuelMode::Batched && !trace) {
+            // gather each chunk's pairs into flat index arrays for the kernel
+            parallelFor(pairs, threads, chunk, [&](long long begin, long long end, int) {
+                int a[chunk] = {}, b[chunk] = {};
+                DuelResult r[chunk];
+                long long n = end - begin;
+                for (long long i = 0; i < n; ++i) {
+                    a[i] = live_players[slot(2 * (begin + i))];
+                    b[i] = live_players[slot(2 * (begin + i) + 1)];
+                }
+                resolveDuelBatch<Rules>(players, a, b, n, seed, game_id, (uint32_t)round, r);
+                for (long long i = 0; i < n; ++i) bracket_winners[begin + i] = r[i].winner;
+            });
+        } else
+#if LAB3_HAVE_COROUTINES
+        if (duel_mode == DuelMode::Interleaved && !trace) {
+            // each chunk's duels advance one swing per step, side by side
+            parallelFor(pairs, threads, chunk, [&](long long begin, long long end, int) {
+                DuelScheduler<Rules> duels((int)chunk);
+                for (long long i = begin; i < end; ++i) {
+                    int a = live_players[slot(2 * i)];
+                    int b = live_players[slot(2 * i + 1)];
+                    duels.add(Player(&players, a), Player(&players, b),
+                              CounterRng(seed, game_id, (uint32_t)round, (uint32_t)a));
+                }
+                duels.run();
+                for (long long i = begin; i < end; ++i) {
+                    bracket_winners[i] = duels.results()[i - begin].winner;
+                }
+            });
+        } else
+#endif
+        parallelFor(pairs, threads, chunk, [&](long long begin, long long end, int) {
+            for (long long i = begin; i < end; ++i) {
+                Player p1(&players, live_players[slot(2 * i)]);
+                Player p2(&players, live_players[slot(2 * i + 1)]);
+                bracket_winners[i] = fight(p1, p2).winner;
+            }
+        });
+    }
+    ++round;
+
+    // endRound bookkeeping for the whole round at once: rebuild the packed
+    // array from the winners (bye kept in place) instead of swap-removing
+    LAB3_PHASE(PHASE_REPORTING);
+    int bye_player = (bye < alive) ? live_players[bye] : -1;
+    for (long long i = 0; i < pairs; ++i) {
+        int a = live_players[slot(2 * i)];
+        int b = live_players[slot(2 * i + 1)];
+        int w = bracket_winners[i];
+        int l = (w == a) ? b : a;
+        Player winner(&players, w);
+        Player loser(&players, l);
+        winner.setHitsTaken(0);
+        int level_before = winner.getLevel();
+        winner.updateExpLevel();
+        live_pos[l] = -1;
+        if (trace) trace->result(round, w, l, winner.getExp(), winner.getLevel() - level_before);
+        sink->elimination(round, players, winner.getId(), loser.getId());
+    }
+    weights_stale = true;               // half the field changed at once
+    long long bye_at = (bye + 1) / 2;   // number of pairs ahead of the bye
+    live_players.clear();
+    for (long long i = 0; i < pairs; ++i) {
+        if (bye_player >= 0 && i == bye_at) live_players.push_back(bye_player);
+        live_players.push_back(bracket_winners[i]);
+    }
+    if (bye_player >= 0 && bye_at == pairs) live_players.push_back(bye_player);
+    for (int s = 0; s < (int)live_players.size(); ++s) {
+        live_pos[live_players[s]] = s;
+    }
+}
+
+// The same fixed bracket over the bitset: alive players in index order are
+// the slots, so a round pairs neighbours exactly as bracketRound does when
+// the game has only ever played brackets. No per-player index arrays: each
+// chunk finds its first fighter with select() and walks on with next(), and
+// the outcomes are kept as one bit per pair until the bookkeeping pass.
+template <class Rules>
+void BasicGame<Rules>::bracketRoundBits(int threads) {
+    long long alive = live_bits.count();
+    long long bye = (alive % 2 == 1) ? uniform_int_distribution<long long>(0, alive - 1)(rng) : alive;
+    long long pairs = alive / 2;
+    auto slot = [bye](long long k) { return k < bye ? k : k + 1; };
+    bracket_p1_won.assign((pairs + 63) / 64, 0);
+    live_bits.refresh();                // select() below needs the current ranks
+
+    // chunks are whole words of bracket_p1_won, so no two threads share one
+    const long long chunk = 256;
+    if (trace) threads = 1;
+    {
+        LAB3_PHASE(PHASE_COMBAT);
+        parallelFor(pairs, threads, chunk, [&](long long begin, long long end, int) {
+            int a[chunk] = {}, b[chunk] = {};
+            long long n = end - begin;
+            long long rank = slot(2 * begin);
+            int cur = live_bits.select((int)rank);
+            for (long long i = 0; i < n; ++i) {
+                for (; rank < slot(2 * (begin + i)); ++rank) cur = live_bits.next(cur + 1);
+                a[i] = cur;
+                for (; rank < slot(2 * (begin + i) + 1); ++rank) cur = live_bits.next(cur + 1);
+                b[i] = cur;
+            }
+            if (duel_mode == DuelMode::Batched && !trace) {
+                DuelResult r[chunk];
+                resolveDuelBatch<Rules>(players, a, b, n, seed, game_id, (uint32_t)round, r);
+                for (long long i = 0; i < n; ++i) {
+                    if (r[i].winner == a[i]) bracket_p1_won[(begin + i) >> 6] |= 1ULL << ((begin + i) & 63);
+                }
+            } else {
+                for (long long i = 0; i < n; ++i) {
+                    if (fight(Player(&players, a[i]), Player(&players, b[i])).winner == a[i])
+                        bracket_p1_won[(begin + i) >> 6] |= 1ULL << ((begin + i) & 63);
+                }
+            }
+        });
+    }
+    ++round;
+
+    LAB3_PHASE(PHASE_REPORTING);
+    int cur = live_bits.next(0);
+    long long rank = 0;
+    for (long long i = 0; i < pairs; ++i) {
+        for (; rank < slot(2 * i); ++rank) cur = live_bits.next(cur + 1);
+        int a = cur;
+        for (; rank < slot(2 * i + 1); ++rank) cur = live_bits.next(cur + 1);
+        int b = cur;
+        bool p1_won = (bracket_p1_won[i >> 6] >> (i & 63)) & 1;
+        int w = p1_won ? a : b;
+        int l = p1_won ? b : a;
+        Player winner(&players, w);
+        winner.setHitsTaken(0);
+        int level_before = winner.getLevel();
+        winner.updateExpLevel();
+        live_bits.remove(l);            // behind the walk, so next() is unaffected
+        if (trace) trace->result(round, w, l, winner.getExp(), winner.getLevel() - level_before);
+        sink->elimination(round, players, w, l);
+    }
+    weights_stale = true;
 }
 
-void Game::gameLoop() {
-    while (live_players.size() > 1) {
+template <class Rules>
+void BasicGame<Rules>::bracketLoop(int threads) {
+    if (threads <= 0) threads = defaultThreads();
+    loop = Loop::Bracket;
+    while (getNumAlive() > 1) {
+        bracketRound(threads);
+        checkpointIfDue();
+    }
+    sink->flush();
+    if (report_stats) LAB3_STATS_DUMP();
+}
+
+template <class Rules>
+void BasicGame<Rules>::gameLoop() {
+    loop = Loop::Battle;
+    while (getNumAlive() > 1) {
         battleRound();
+        checkpointIfDue();
+    }
+    sink->flush();
+    // silent games (Monte Carlo workers) leave the dump to their runner
+    if (report_stats) LAB3_STATS_DUMP();
+}
+
+template <class Rules>
+void BasicGame<Rules>::checkpointIfDue() {
+    if (checkpoint_every <= 0 || round % checkpoint_every != 0 || getNumAlive() <= 1) return;
+    if (!saveCheckpoint(checkpoint_path)) cerr << "cannot write checkpoint " << checkpoint_path << '\n';
+}
+
+// Field order is the file format; resume() reads them back in the same order.
+// The big columns go to the file straight from the pool and the live set.
+template <class Rules>
+bool BasicGame<Rules>::saveCheckpoint(const string& path) const {
+    CheckpointWriter out(Rules::NAME);
+    out.value(seed);
+    out.value(game_id);
+    out.value(round);
+    out.value(duel_mode);
+    out.value(matchmaking);
+    out.value(liveness);
+    out.value(loop);
+    out.value(weights_stale);
+    ostringstream engine;
+    engine << rng;
+    string engine_state = engine.str();
+    out.text(engine_state);
+    players.save(out);
+    if (liveness == Liveness::Bitset) live_bits.save(out);
+    else out.column(live_players);
+    if (!weights_stale) weights.save(out);
+    return out.commit(path);
+}
+
+template <class Rules>
+bool BasicGame<Rules>::resume(const string& path) {
+    CheckpointReader in(path);
+    if (!in.ok() || in.rules() != Rules::NAME) return false;
+    // a rejected file leaves an empty game in the default modes, whatever it set
+    auto reject = [&]() {
+        duel_mode = DuelMode::Analytic;
+        matchmaking = Matchmaking::Uniform;
+        liveness = Liveness::Packed;
+        reset(seed);
+        return false;
+    };
+    reset(seed);
+    in.value(seed);
+    in.value(game_id);
+    in.value(round);
+    in.value(duel_mode);
+    in.value(matchmaking);
+    in.value(liveness);
+    in.value(loop);
+    in.value(weights_stale);
+    // modes are raw bytes in the file: one we do not know is a bad file
+    if (!in.ok() || (unsigned)duel_mode > (unsigned)DuelMode::Batched ||
+        (unsigned)matchmaking > (unsigned)Matchmaking::ByLuck ||
+        (unsigned)liveness > (unsigned)Liveness::Bitset || (unsigned)loop > (unsigned)Loop::Bracket) {
+        return reject();
+    }
+    string engine_state;
+    in.text(engine_state);
+    istringstream engine(engine_state);
+    engine >> rng;
+    players.load(in);
+    bool valid = in.ok() && !engine.fail();
+    if (liveness == Liveness::Bitset) {
+        live_bits.load(in);
+        valid = valid && in.ok() && live_bits.size() == players.size();
+    } else {
+        // live_pos is the inverse of live_players, so it is rebuilt rather than stored
+        in.column(live_players);
+        live_pos.assign(players.size(), -1);
+        for (int s = 0; valid && s < (int)live_players.size(); ++s) {
+            int id = live_players[s];
+            valid = id >= 0 && id < players.size() && live_pos[id] < 0;
+            if (valid) live_pos[id] = s;
+        }
+        valid = valid && in.ok();
     }
+    if (!weights_stale) {
+        weights.load(in);
+        valid = valid && in.ok() && weights.size() == players.size();
+    }
+    return valid || reject();
 }
 
-void Game::printFinalResults() const {
-    for (const RPG* p : players) {
-        p->printStats();
-    
+template <class Rules>
+void BasicGame<Rules>::resumeLoop(int threads) {
+    if (loop == Loop::Bracket) bracketLoop(threads);
+    else gameLoop();
+}
+
+template <class Rules>
+void BasicGame<Rules>::printFinalResults() const {
+    LAB3_PHASE(PHASE_REPORTING);
+    for (int i = 0; i < players.size(); ++i) {
+        sink->playerStats(players, i, players.hitsTaken(i) < Rules::MAX_HITS_TAKEN);
     }
+    sink->flush();
+}
+
+template <class Rules>
+bool BasicGame<Rules>::exportResults(const string& path, ExportFormat format, int threads) const {
+    LAB3_PHASE(PHASE_REPORTING);
+    return ResultExporter(threads).write(players, Rules::MAX_HITS_TAKEN, format, path);
 }
+
+#define LAB3_INSTANTIATE_GAME(R) template class BasicGame<R>;
+LAB3_FOR_EACH_RULES(LAB3_INSTANTIATE_GAME)
@@ -1,25 +1,117 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <string>
 #include <vector>
-#include <set>
+#include "Checkpoint.h"
+#include "PlayerPool.h"
 #include "RPG.h"
+#include "Duel.h"
+#include "EventSink.h"
+#include "FenwickTree.h"
+#include "LiveBitset.h"
+#include "ResultExport.h"
+#include "Roster.h"
+#include "Trace.h"
+#include "Rng.h"
+#include "Rules.h"
 using namespace std;
 
-class Game {
+// How battleRound picks its two fighters among the alive players.
+enum class Matchmaking {
+    Uniform,      // every alive player equally likely (default)
+    ByLevel,      // chance proportional to level
+    ByLuck        // chance proportional to luck
+};
+
+// How the alive players are tracked.
+enum class Liveness {
+    Packed,       // packed index array + position map, 8 bytes per player (default)
+    Bitset        // one bit per player with a rank index (LiveBitset), ~1.1 bits;
+                  // uniform picks take a different draw than Packed, brackets match it
+};
+
+// Rules fixes the combat and leveling constants at compile time; Game is the
+// classic set. Instantiated in Game.cpp for every LAB3_FOR_EACH_RULES entry.
+template <class Rules>
+class BasicGame {
 public:
-    Game();
+    typedef BasicRPG<Rules> Player;
+
+    BasicGame();                         // seeded from random_device
+    explicit BasicGame(uint64_t seed);   // reproducible run
 
-    void generatePlayers(int n);    // NPC_0..NPC_(n-1)
-    int  selectPlayer();            // choose a random alive index
+    void generatePlayers(int n);    // n default players, named NPC_<index>
+    bool loadPlayers(const string& path, string* error = nullptr, int threads = 0); // add a roster file
+    int  addPlayer(const string& name, int hits_taken, float luck, float exp, int level); // returns its index
+    int  selectPlayer();            // choose a random alive index (see setMatchmaking)
     void battleRound();             // two distinct players fight to a KO
-    void endRound(RPG* winner, RPG* loser, int loserIndex);
+    void endRound(Player winner, Player loser, int loserIndex);
     void gameLoop();                // repeat rounds until one remains
+    void bracketRound(int threads); // pair every alive player, duels run in parallel
+    void bracketLoop(int threads = 0); // single elimination until one remains
     void printFinalResults() const; // print everyone
+    bool exportResults(const string& path, ExportFormat format, int threads = 0) const; // the same rows, to a file
+    void reset(uint64_t seed);      // empty the game for reuse, keeps storage
+    void reserve(int n);            // size all player storage for n up front
+
+    void     setDuelMode(DuelMode mode); // Analytic (default) or Swings
+    void     setMatchmaking(Matchmaking m); // Uniform (default), ByLevel or ByLuck
+    void     setLiveness(Liveness l);  // Packed (default) or Bitset; before generatePlayers
+    void     setEventSink(EventSink& sink); // output target (default stdoutSink())
+    void     setGameId(uint64_t id); // second half of the duel stream key (default 0)
+    void     setReportStats(bool on); // dump -DLAB3_STATS counters after each loop (default on)
+    void     setTrace(TraceWriter* trace); // record every swing and result (nullptr = off)
+    void     setCheckpoint(const string& path, long long every); // snapshot every `every` rounds (0 = off)
+
+    // A checkpoint holds everything the rest of the run depends on: the
+    // pool, the live set, the selection engine, the round and the modes.
+    // A resumed game plays on exactly as the original would have. Sinks,
+    // traces and checkpoint settings are not part of it.
+    bool     saveCheckpoint(const string& path) const;
+    bool     resume(const string& path); // false (and an empty game) if unreadable or other rules
+    void     resumeLoop(int threads = 0); // go on with the loop that wrote the checkpoint
+    uint64_t getSeed() const;
+    Player   getPlayer(int index);  // handle into the pool
+    int      getNumPlayers() const;
+    int      getNumAlive() const;
+    int      getChampion() const;   // last alive index, -1 until decided
+    long long getRound() const;     // rounds played so far
 
 private:
-    vector<RPG*> players;           // owns RPG*, delete in ~Game
-    set<int>     live_players;      // alive indices into players
+    DuelResult fight(Player p1, Player p2) const; // keyed by (seed, game id, round, p1)
+    double     weightOf(int index) const;   // matchmaking weight, 0 once eliminated
+    int        selectWeighted(int exclude); // weighted pick, never `exclude`
+    void       reweigh(int index);          // refresh index's weight in the tree
+    bool       isLive(int index) const;
+    void       enlist(int first, int n);    // live set for new players [first, first + n)
+    void       checkpointIfDue();          // after each round of either loop
+    void       bracketRoundBits(int threads); // bracketRound for Liveness::Bitset
+
+    PlayerPool   players;           // owns every player's stats
+    vector<int>  live_players;      // packed alive indices into players
+    vector<int>  live_pos;          // players index -> slot in live_players (-1 if out)
+    Liveness     liveness;
+    LiveBitset   live_bits;         // replaces live_players and live_pos under Bitset
+    uint64_t     seed;
+    uint64_t     game_id;
+    GameRng      rng;               // sequential engine for selection and byes
+    DuelMode     duel_mode;
+    Matchmaking  matchmaking;
+    FenwickTree  weights;           // by pool index; only kept for weighted matchmaking
+    bool         weights_stale;     // rebuild before the next weighted pick
+    EventSink*   sink;              // not owned
+    TraceWriter* trace;             // not owned
+    bool         report_stats;
+    long long    round;
+    enum class Loop : uint8_t { None, Battle, Bracket };
+    Loop         loop;              // running (or resumed) loop, for resumeLoop
+    string       checkpoint_path;
+    long long    checkpoint_every;  // rounds between snapshots, 0 = off
+    vector<int>  bracket_winners;   // scratch for bracketRound, one per pair
+    vector<uint64_t> bracket_p1_won; // scratch for bracketRoundBits, one bit per pair
 };
 
+typedef BasicGame<ClassicRules> Game;
+
 #endif
@@ -0,0 +1,176 @@
+#include "LiveBitset.h"
+#include <algorithm>
+using namespace std;
+
+// position of the r-th set bit of w (r < popcount(w)), a byte at a time
+static int selectInWord(uint64_t w, int r) {
+    for (int shift = 0;; shift += 8) {
+        uint32_t b = (uint32_t)(w >> shift) & 0xFF;
+        int c = __builtin_popcount(b);
+        if (r < c) {
+            while (r-- > 0) b &= b - 1;     // drop the lower set bits
+            return shift + __builtin_ctz(b);
+        }
+        r -= c;
+    }
+}
+
+void LiveBitset::clear() {
+    bits.clear();
+    start.clear();
+    local.clear();
+    players = alive = indexed = 0;
+    stale = grown = false;
+}
+
+void LiveBitset::grow(int n) {
+    int first = players;
+    players += n;
+    alive += n;
+    bits.resize((players + 63) / 64, 0);
+    local.resize((players + SUPER_BITS - 1) / SUPER_BITS, 0);
+    for (int i = first; i < players && (i & 63); ++i) {   // ragged head
+        bits[i >> 6] |= 1ULL << (i & 63);
+        ++local[i / SUPER_BITS];
+    }
+    int i = (first + 63) & ~63;
+    for (; i + 64 <= players; i += 64) {                  // whole words
+        bits[i >> 6] = ~0ULL;
+        local[i / SUPER_BITS] += 64;
+    }
+    for (; i < players; ++i) {                            // ragged tail
+        bits[i >> 6] |= 1ULL << (i & 63);
+        ++local[i / SUPER_BITS];
+    }
+    grown = true;
+}
+
+void LiveBitset::remove(int i) {
+    uint64_t& w = bits[i >> 6];
+    uint64_t m = 1ULL << (i & 63);
+    if (!(w & m)) return;
+    w &= ~m;
+    --local[i / SUPER_BITS];
+    --alive;
+    stale = true;
+}
+
+void LiveBitset::refresh() {
+    start.resize(local.size() + 1);
+    uint32_t sum = 0;
+    for (size_t s = 0; s < local.size(); ++s) {
+        start[s] = sum;
+        sum += local[s];
+    }
+    start[local.size()] = sum;
+    indexed = (int)sum;
+    stale = grown = false;
+}
+
+int LiveBitset::selectIn(int super, int r) const {
+    size_t w = (size_t)super * SUPER_WORDS;
+    for (;; ++w) {
+        int c = __builtin_popcountll(bits[w]);
+        if (r < c) return (int)(w * 64) + selectInWord(bits[w], r);
+        r -= c;
+    }
+}
+
+// Deaths are spread fairly evenly, so the ranks grow almost linearly with
+// the superblock: guess by interpolation and step from there, falling back
+// to binary search if the guess is far off. Empty superblocks share their
+// start with the next one, so this finds the last superblock starting <= r.
+int LiveBitset::superFor(int r) const {
+    int last = (int)local.size() - 1;
+    int s = (int)((long long)r * (last + 1) / max(indexed, 1));
+    if (s > last) s = last;
+    for (int steps = 0; steps < 8; ++steps) {
+        if ((int)start[s] > r) --s;
+        else if (s < last && (int)start[s + 1] <= r) ++s;
+        else return s;
+    }
+    int lo = 0, hi = last;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if ((int)start[mid] <= r) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+int LiveBitset::select(int r) const {
+    int s = superFor(r);
+    return selectIn(s, r - (int)start[s]);
+}
+
+int LiveBitset::next(int i) const {
+    if (i >= players) return players;
+    size_t w = (size_t)i >> 6;
+    uint64_t word = bits[w] & (~0ULL << (i & 63));
+    while (word == 0) {
+        if (++w == bits.size()) return players;
+        word = bits[w];
+    }
+    return (int)(w * 64) + __builtin_ctzll(word);
+}
+
+void LiveBitset::save(CheckpointWriter& out) const {
+    out.value(players);
+    out.value(alive);
+    out.value(indexed);
+    out.value(stale);
+    out.value(grown);
+    out.column(bits);
+    out.column(start);
+    out.column(local);
+}
+
+void LiveBitset::load(CheckpointReader& in) {
+    clear();
+    in.value(players);
+    in.value(alive);
+    in.value(indexed);
+    in.value(stale);
+    in.value(grown);
+    in.column(bits);
+    in.column(start);
+    in.column(local);
+    bool shaped = players >= 0 && bits.size() == ((size_t)players + 63) / 64 &&
+                  local.size() == ((size_t)players + SUPER_BITS - 1) / SUPER_BITS &&
+                  (start.empty() || start.size() == local.size() + 1);
+    if (!in.ok() || !shaped || !consistent()) {
+        in.fail();
+        clear();
+    }
+}
+
+// What sample() and select() rely on: local and alive are the exact counts,
+// no bit past the last player, and unless a grow() forces a refresh first,
+// start runs from 0 to indexed with room for every superblock's alive players
+// (exactly room when nothing has been removed since).
+bool LiveBitset::consistent() const {
+    if (players % 64 != 0 && (bits.back() >> (players % 64)) != 0) return false;
+    long long total = 0;
+    for (size_t s = 0; s < local.size(); ++s) {
+        int c = 0;
+        for (size_t w = s * SUPER_WORDS; w < min(bits.size(), (s + 1) * SUPER_WORDS); ++w)
+            c += __builtin_popcountll(bits[w]);
+        if (local[s] != c) return false;
+        total += c;
+    }
+    if (total != alive || indexed < 0) return false;
+    if (grown) return true;
+    if (start.empty()) return players == 0 && indexed == 0;
+    if (start[0] != 0 || start.back() != (uint32_t)indexed || alive > indexed) return false;
+    for (size_t s = 0; s < local.size(); ++s) {
+        if (start[s + 1] < start[s]) return false;
+        uint32_t room = start[s + 1] - start[s];
+        if (room < local[s] || (!stale && room != local[s])) return false;
+    }
+    return true;
+}
+
+size_t LiveBitset::bytes() const {
+    return bits.capacity() * sizeof(uint64_t) + start.capacity() * sizeof(uint32_t) +
+           local.capacity() * sizeof(uint16_t);
+}
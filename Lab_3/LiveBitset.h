@@ -0,0 +1,71 @@
+#ifndef LIVEBITSET_H
+#define LIVEBITSET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Checkpoint.h"
+using namespace std;
+
+// Alive flags for every player in one bit each, with a rank index for
+// select and uniform sampling. About 1.09 bits per player in total:
+//   bits    1 bit per player
+//   start   32 bits per 512-bit superblock: alive before it, as of refresh()
+//   local   16 bits per superblock: alive in it now, always exact
+// remove() is O(1) and leaves `start` stale. sample() stays uniform anyway:
+// it draws a slot among the alive players counted at the last refresh and
+// rejects slots whose player has since died, so it refreshes itself once
+// fewer than half of those are left (acceptance stays above 1/2).
+class LiveBitset {
+public:
+    void clear();
+    void grow(int n);               // n more players, all alive
+    int  size() const { return players; }
+    int  count() const { return alive; }
+    bool test(int i) const { return (bits[i >> 6] >> (i & 63)) & 1; }
+    void remove(int i);             // mark i dead; O(1)
+    void refresh();                 // rebuild `start`; O(size / 512)
+    bool fresh() const { return !stale && !grown; }
+    int  select(int r) const;       // r-th alive player (0-based) in index order; needs fresh()
+    int  next(int i) const;         // first alive player >= i, or size()
+    size_t bytes() const;           // memory held
+    void save(CheckpointWriter& out) const; // stale ranks included, so sample() draws the same
+    void load(CheckpointReader& in);
+
+    // uniform over the alive players, usually O(1) per attempt
+    template <class Engine> int sample(Engine& rng);
+
+private:
+    static const int SUPER_BITS = 512;
+    static const int SUPER_WORDS = SUPER_BITS / 64;
+
+    bool consistent() const;        // after load(): counts and ranks agree with bits
+    int superFor(int r) const;      // superblock whose refresh-time range holds rank r
+    int selectIn(int super, int r) const; // r-th alive player inside one superblock
+
+    vector<uint64_t> bits;
+    vector<uint32_t> start;         // size supers + 1
+    vector<uint16_t> local;
+    int              players = 0;
+    int              alive = 0;
+    int              indexed = 0;   // alive at the last refresh
+    bool             stale = false; // removals since the last refresh
+    bool             grown = false; // players added since the last refresh
+};
+
+template <class Engine>
+int LiveBitset::sample(Engine& rng) {
+    if (grown || alive * 2 < indexed) refresh();
+    uniform_int_distribution<int> dis(0, indexed - 1);
+    for (;;) {
+        int slot = dis(rng);
+        int super = superFor(slot);
+        int r = slot - (int)start[super];
+        // each of the local[super] players still alive owns one of the superblock's
+        // refresh-time slots; the rest belong to players removed since
+        if (r < local[super]) return selectIn(super, r);
+    }
+}
+
+#endif
@@ -0,0 +1,169 @@
+#include "MonteCarloRunner.h"
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include "Game.h"
+#include "Parallel.h"
+#include "Rng.h"
+#include "Stats.h"
+using namespace std;
+
+static void addTo(vector<long long>& hist, int bucket, long long count) {
+    if ((int)hist.size() <= bucket) hist.resize(bucket + 1, 0);
+    hist[bucket] += count;
+}
+
+void MonteCarloResult::merge(const MonteCarloResult& other) {
+    games += other.games;
+    for (int i = 0; i < (int)other.wins_by_player.size(); ++i)
+        addTo(wins_by_player, i, other.wins_by_player[i]);
+    for (int i = 0; i < (int)other.champion_levels.size(); ++i)
+        addTo(champion_levels, i, other.champion_levels[i]);
+    for (int i = 0; i < (int)other.player_levels.size(); ++i)
+        addTo(player_levels, i, other.player_levels[i]);
+}
+
+Interval MonteCarloResult::share(long long hits, long long n, double z) {
+    if (n <= 0) return { 0.0, 1.0 };
+    double p = (double)hits / n;
+    double z2n = z * z / n;
+    double center = (p + z2n / 2) / (1 + z2n);
+    double half = z * sqrt(p * (1 - p) / n + z2n / (4 * n)) / (1 + z2n);
+    return { max(0.0, center - half), min(1.0, center + half) };
+}
+
+double MonteCarloResult::meanChampionLevel() const {
+    if (games == 0) return 0.0;
+    double sum = 0.0;
+    for (int lv = 0; lv < (int)champion_levels.size(); ++lv) sum += (double)lv * champion_levels[lv];
+    return sum / games;
+}
+
+Interval MonteCarloResult::meanChampionLevelInterval(double z) const {
+    double mean = meanChampionLevel();
+    if (games < 2) return { mean, mean };
+    double squares = 0.0;
+    for (int lv = 0; lv < (int)champion_levels.size(); ++lv) {
+        squares += (lv - mean) * (lv - mean) * champion_levels[lv];
+    }
+    double half = z * sqrt(squares / (games - 1) / games);
+    return { mean - half, mean + half };
+}
+
+MonteCarloRunner::MonteCarloRunner(int n, unsigned s, int t, const string& r)
+    : players_per_game(n), seed(s), threads(t <= 0 ? defaultThreads() : t), rules(r) {
+    // a game needs a champion to tally
+    if (n < 1) throw invalid_argument("MonteCarloRunner: players_per_game must be at least 1");
+}
+
+uint64_t MonteCarloRunner::gameSeed(unsigned seed, long long game) {
+    uint64_t state = ((uint64_t)seed << 32) ^ (uint64_t)game;
+    return splitmix64(state);
+}
+
+// one per thread, cache-line aligned so neighbours never share a line
+template <class Rules>
+struct alignas(64) Worker {
+    BasicGame<Rules> game;
+    MonteCarloResult result;
+
+    Worker() : game(0u) {}
+};
+
+MonteCarloResult MonteCarloRunner::run(long long games) {
+    MonteCarloResult total;
+    withRules(rules, [&](auto r) { total = runWith<decltype(r)>(games); });
+    return total;
+}
+
+// one finished game into a worker's histograms
+template <class Rules>
+static void tally(BasicGame<Rules>& g, MonteCarloResult& out) {
+    BasicRPG<Rules> champ = g.getPlayer(g.getChampion());
+    out.games += 1;
+    out.wins_by_player[champ.getId()] += 1;
+    addTo(out.champion_levels, champ.getLevel(), 1);
+    for (int p = 0; p < g.getNumPlayers(); ++p)
+        addTo(out.player_levels, g.getPlayer(p).getLevel(), 1);
+}
+
+template <class Rules>
+static void setUp(vector<Worker<Rules> >& workers, int players_per_game) {
+    for (Worker<Rules>& w : workers) {
+        w.game.setEventSink(silentSink());
+        w.game.setReportStats(false);   // one dump for the whole run instead
+        w.game.reserve(players_per_game);
+        w.result.wins_by_player.assign(players_per_game, 0);
+    }
+}
+
+template <class Rules>
+MonteCarloResult MonteCarloRunner::runWith(long long games) {
+    // the Game (and its player storage) is reused for every game a worker runs
+    vector<Worker<Rules> > workers(threads);
+    setUp(workers, players_per_game);
+
+    parallelFor(games, threads, 16, [&](long long begin, long long end, int w) {
+        BasicGame<Rules>& g = workers[w].game;
+        for (long long i = begin; i < end; ++i) {
+            g.reset(gameSeed(seed, i));
+            g.setGameId(i);
+            g.generatePlayers(players_per_game);
+            g.gameLoop();
+            tally(g, workers[w].result);
+        }
+    });
+
+    MonteCarloResult total;
+    for (const Worker<Rules>& w : workers) total.merge(w.result);
+    LAB3_STATS_DUMP();
+    return total;
+}
+
+MonteCarloResult MonteCarloRunner::runUntil(chrono::steady_clock::time_point deadline) {
+    MonteCarloResult total;
+    withRules(rules, [&](auto r) { total = runUntilWith<decltype(r)>(deadline); });
+    return total;
+}
+
+// Games are claimed one at a time, so a stop leaves no claimed game
+// unplayed. Each worker reads the clock every `stride` games and adapts
+// the stride to about a millisecond between reads, whatever a game costs.
+template <class Rules>
+MonteCarloResult MonteCarloRunner::runUntilWith(chrono::steady_clock::time_point deadline) {
+    typedef chrono::steady_clock Clock;
+    vector<Worker<Rules> > workers(threads);
+    setUp(workers, players_per_game);
+    atomic<long long> next(0);
+    atomic<bool> stop(Clock::now() >= deadline);
+
+    parallelFor(threads, threads, 1, [&](long long, long long, int w) {
+        BasicGame<Rules>& g = workers[w].game;
+        Clock::time_point last = Clock::now();
+        long long stride = 1, since = 0;
+        while (!stop.load(memory_order_relaxed)) {
+            long long i = next.fetch_add(1, memory_order_relaxed);
+            g.reset(gameSeed(seed, i));
+            g.setGameId(i);
+            g.generatePlayers(players_per_game);
+            g.gameLoop();
+            tally(g, workers[w].result);
+
+            if (++since < stride) continue;
+            since = 0;
+            Clock::time_point now = Clock::now();
+            if (now >= deadline) {
+                stop.store(true, memory_order_relaxed);
+                break;
+            }
+            if (now - last < chrono::milliseconds(1)) stride *= 2;
+            else if (now - last > chrono::milliseconds(4) && stride > 1) stride /= 2;
+            last = now;
+        }
+    });
+
+    MonteCarloResult total;
+    for (const Worker<Rules>& w : workers) total.merge(w.result);
+    LAB3_STATS_DUMP();
+    return total;
+}
@@ -0,0 +1,63 @@
+#ifndef MONTECARLORUNNER_H
+#define MONTECARLORUNNER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// A two-sided confidence interval.
+struct Interval {
+    double low;
+    double high;
+};
+
+// Histograms gathered over many independent games.
+struct MonteCarloResult {
+    long long         games = 0;
+    vector<long long> wins_by_player;   // player index -> championships
+    vector<long long> champion_levels;  // level -> championships won at that level
+    vector<long long> player_levels;    // level -> players finishing at that level
+
+    void merge(const MonteCarloResult& other);
+
+    // Intervals default to 95% (z = 1.96). A share such as
+    // champion_levels[lv] / games uses the Wilson score interval, which
+    // stays inside [0, 1] for rare levels; the mean uses the normal one.
+    static Interval share(long long hits, long long n, double z = 1.96);
+    double   meanChampionLevel() const;
+    Interval meanChampionLevelInterval(double z = 1.96) const;
+};
+
+// Runs many Game instances across worker threads. Every game gets its own
+// seed derived from (seed, game number), so results do not depend on which
+// thread ran which game. rules names the BasicGame instantiation to play
+// (see Rules.h); an unknown name runs no games. players_per_game below 1
+// throws invalid_argument.
+class MonteCarloRunner {
+public:
+    MonteCarloRunner(int players_per_game, unsigned seed, int threads = 0,
+                     const string& rules = "classic");
+
+    MonteCarloResult run(long long games);
+    // As many games as fit before the deadline. Workers read the clock
+    // every few games, not every duel, and the first to see it pass stops
+    // the rest; they finish the game in hand, so a run overshoots by about
+    // one game. Game i is seeded as under run(), but which games finish
+    // depends on timing.
+    MonteCarloResult runUntil(chrono::steady_clock::time_point deadline);
+
+    static uint64_t gameSeed(unsigned seed, long long game); // all 64 bits, no birthday collisions at scale
+
+private:
+    template <class Rules> MonteCarloResult runWith(long long games);
+    template <class Rules> MonteCarloResult runUntilWith(chrono::steady_clock::time_point deadline);
+
+    int      players_per_game;
+    unsigned seed;
+    int      threads;                   // 0 = hardware_concurrency
+    string   rules;
+};
+
+#endif
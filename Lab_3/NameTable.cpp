@@ -0,0 +1,25 @@
+#include "NameTable.h"
+using namespace std;
+
+NameTable::NameTable(const NameTable& other) : strings(other.strings) {
+    for (size_t i = 0; i < strings.size(); ++i) ids.emplace(string_view(strings[i]), (uint32_t)(i + 1));
+}
+
+NameTable& NameTable::operator=(const NameTable& other) {
+    if (this != &other) *this = NameTable(other);
+    return *this;
+}
+
+uint32_t NameTable::intern(string_view name) {
+    auto found = ids.find(name);
+    if (found != ids.end()) return found->second;
+    strings.emplace_back(name);
+    uint32_t id = (uint32_t)strings.size();
+    ids.emplace(string_view(strings.back()), id);
+    return id;
+}
+
+void NameTable::clear() {
+    ids.clear();
+    strings.clear();
+}
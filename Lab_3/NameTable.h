@@ -0,0 +1,32 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+using namespace std;
+
+// Interned custom names: each distinct string is stored once and referred
+// to by a small id. Id 0 is never handed out, so callers can use it for
+// "no custom name".
+class NameTable {
+public:
+    NameTable() {}
+    NameTable(const NameTable& other);  // rebuilds the index over its own copies
+    NameTable(NameTable&& other) = default;
+    NameTable& operator=(const NameTable& other);
+    NameTable& operator=(NameTable&& other) = default;
+
+    uint32_t      intern(string_view name);
+    const string& get(uint32_t id) const { return strings[id - 1]; }
+    size_t        size() const { return strings.size(); }
+    void          clear();
+
+private:
+    deque<string>                          strings;   // stable addresses for the keys
+    unordered_map<string_view, uint32_t>   ids;
+};
+
+#endif
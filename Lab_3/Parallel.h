@@ -0,0 +1,41 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Worker count to use when the caller passes 0.
+inline int defaultThreads() {
+    unsigned n = thread::hardware_concurrency();
+    return n == 0 ? 1 : (int)n;
+}
+
+// Runs body(begin, end, worker) over [0, count) on `threads` workers.
+// Chunks are claimed from a shared counter, so workers that draw short
+// tasks simply come back for more (dynamic balancing, no central queue).
+template <class Body>
+void parallelFor(long long count, int threads, long long chunk, Body body) {
+    if (threads <= 0) threads = defaultThreads();
+    if (chunk <= 0) chunk = 1;
+    atomic<long long> next(0);
+    auto work = [&](int worker) {
+        for (;;) {
+            long long begin = next.fetch_add(chunk);
+            if (begin >= count) break;
+            body(begin, min(begin + chunk, count), worker);
+        }
+    };
+    if (threads == 1 || count <= chunk) {
+        work(0);
+        return;
+    }
+    vector<thread> pool;
+    for (int w = 1; w < threads; ++w) pool.emplace_back(work, w);
+    work(0);
+    for (thread& t : pool) t.join();
+}
+
+#endif
@@ -0,0 +1,212 @@
+#include "PlayerPool.h"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+using namespace std;
+
+PlayerPool::PlayerPool()
+    : hits_taken(nullptr), luck(nullptr), exp(nullptr), level(nullptr), count(0), cap(0) {}
+
+PlayerPool::PlayerPool(const PlayerPool& other) : PlayerPool() {
+    reserve(other.count);
+    memcpy(hits_taken, other.hits_taken, other.count * sizeof(int));
+    memcpy(luck, other.luck, other.count * sizeof(float));
+    memcpy(exp, other.exp, other.count * sizeof(float));
+    memcpy(level, other.level, other.count * sizeof(int));
+    count = other.count;
+    name_ids = other.name_ids;
+    custom_names = other.custom_names;
+}
+
+// The column pointers point into the arena, so they travel with it: a
+// moved-from pool must not keep them.
+PlayerPool::PlayerPool(PlayerPool&& other) noexcept : PlayerPool() { swap(other); }
+
+PlayerPool& PlayerPool::operator=(PlayerPool other) {
+    swap(other);
+    return *this;
+}
+
+void PlayerPool::swap(PlayerPool& other) noexcept {
+    std::swap(arena, other.arena);
+    std::swap(hits_taken, other.hits_taken);
+    std::swap(luck, other.luck);
+    std::swap(exp, other.exp);
+    std::swap(level, other.level);
+    std::swap(count, other.count);
+    std::swap(cap, other.cap);
+    std::swap(name_ids, other.name_ids);
+    std::swap(custom_names, other.custom_names);
+}
+
+void PlayerPool::reserve(int n) {
+    if (n <= cap) return;
+    // whole cache lines per column: 16 four-byte fields per 64 bytes, and
+    // the arena starts on a line, so every column does
+    int new_cap = (int)min<long long>(((long long)n + 15) & ~15LL, INT_MAX);
+    size_t column = ((size_t)new_cap * 4 + 63) & ~(size_t)63;
+    unique_ptr<char[], ArenaDelete> block((char*)::operator new[](4 * column, align_val_t(64)));
+    int*   new_hits  = (int*)(block.get());
+    float* new_luck  = (float*)(block.get() + column);
+    float* new_exp   = (float*)(block.get() + 2 * column);
+    int*   new_level = (int*)(block.get() + 3 * column);
+    if (count > 0) {
+        memcpy(new_hits, hits_taken, count * sizeof(int));
+        memcpy(new_luck, luck, count * sizeof(float));
+        memcpy(new_exp, exp, count * sizeof(float));
+        memcpy(new_level, level, count * sizeof(int));
+    }
+    arena.swap(block);
+    hits_taken = new_hits;
+    luck = new_luck;
+    exp = new_exp;
+    level = new_level;
+    cap = new_cap;
+    if (!name_ids.empty()) name_ids.reserve(new_cap);
+}
+
+// Doubles (at least) to fit `more` rows. Sizes are worked out in long long
+// so a pool past 2^30 players does not overflow, and capped at INT_MAX.
+void PlayerPool::grow(int more) {
+    long long need = (long long)count + more;
+    if (need > INT_MAX) throw length_error("PlayerPool: more than INT_MAX players");
+    if (need <= cap) return;
+    reserve((int)min<long long>(max<long long>(need, max(2LL * cap, 1024LL)), INT_MAX));
+}
+
+// same stats the old RPG() constructor used, with an implicit name
+int PlayerPool::add() {
+    if (count == cap) grow(1);
+    hits_taken[count] = 0;
+    luck[count] = 0.1f;
+    exp[count] = 0.0f;
+    level[count] = 1;
+    if (!name_ids.empty()) name_ids.push_back(0);
+    return count++;
+}
+
+int PlayerPool::add(const string& n, int h, float l, float e, int lv) {
+    int id = add();
+    hits_taken[id] = h;
+    luck[id] = l;
+    exp[id] = e;
+    level[id] = lv;
+    setName(id, n);
+    return id;
+}
+
+int PlayerPool::append(int n) {
+    int first = count;
+    grow(n);
+    if (!name_ids.empty()) name_ids.resize(count + n, 0);
+    count += n;
+    return first;
+}
+
+void PlayerPool::truncate(int n) {
+    if (n >= count) return;
+    count = n;
+    if (!name_ids.empty()) name_ids.resize(n);
+}
+
+void PlayerPool::clear() {
+    count = 0;
+    name_ids.clear();
+    custom_names.clear();
+}
+
+// Straight from the columns to the file and back: the arena is sized once
+// and filled in place. Names go out as the interned strings in id order,
+// so interning them again on load hands out the same ids.
+void PlayerPool::save(CheckpointWriter& out) const {
+    out.value(count);
+    out.column(hits_taken, count * sizeof(int));
+    out.column(luck, count * sizeof(float));
+    out.column(exp, count * sizeof(float));
+    out.column(level, count * sizeof(int));
+    out.column(name_ids);
+    out.value((uint32_t)custom_names.size());
+    for (uint32_t id = 1; id <= custom_names.size(); ++id) out.text(custom_names.get(id));
+}
+
+void PlayerPool::load(CheckpointReader& in) {
+    clear();
+    int n = 0;
+    // the row count is only trusted once the file is seen to hold that many
+    if (!in.value(n) || n < 0 || !in.expectColumn((size_t)n * sizeof(int))) return;
+    reserve(n);
+    in.column(hits_taken, n * sizeof(int));
+    in.column(luck, n * sizeof(float));
+    in.column(exp, n * sizeof(float));
+    in.column(level, n * sizeof(int));
+    in.column(name_ids);
+    uint32_t names = 0;
+    in.value(names);
+    string name;
+    for (uint32_t id = 1; id <= names && in.text(name); ++id) custom_names.intern(name);
+    // a repeated name would shift every id after it
+    bool valid = in.ok() && custom_names.size() == names && (name_ids.empty() || (int)name_ids.size() == n);
+    for (size_t i = 0; valid && i < name_ids.size(); ++i) valid = name_ids[i] <= names;
+    if (!valid) {
+        in.fail();
+        clear();
+        return;
+    }
+    count = n;
+}
+
+static const char IMPLICIT_PREFIX[] = "NPC_";
+
+void PlayerPool::appendName(string& out, int i) const {
+    if (hasCustomName(i)) {
+        out.append(custom_names.get(name_ids[i]));
+        return;
+    }
+    char buf[16];
+    out.append(buf, putName(buf, i) - buf);
+}
+
+char* PlayerPool::putName(char* dst, int i) const {
+    if (hasCustomName(i)) {
+        const string& name = custom_names.get(name_ids[i]);
+        memcpy(dst, name.data(), name.size());
+        return dst + name.size();
+    }
+    memcpy(dst, IMPLICIT_PREFIX, sizeof IMPLICIT_PREFIX - 1);
+    dst += sizeof IMPLICIT_PREFIX - 1;
+    return to_chars(dst, dst + 10, i).ptr;
+}
+
+size_t PlayerPool::nameLength(int i) const {
+    if (hasCustomName(i)) return custom_names.get(name_ids[i]).size();
+    size_t digits = 1;
+    for (int v = i; v >= 10; v /= 10) ++digits;
+    return sizeof IMPLICIT_PREFIX - 1 + digits;
+}
+
+string PlayerPool::nameOf(int i) const {
+    string out;
+    appendName(out, i);
+    return out;
+}
+
+bool PlayerPool::isImplicitName(string_view name, int i) {
+    if (name.compare(0, sizeof IMPLICIT_PREFIX - 1, IMPLICIT_PREFIX) != 0) return false;
+    int parsed = -1;
+    const char* first = name.data() + sizeof IMPLICIT_PREFIX - 1;
+    const char* last = name.data() + name.size();
+    from_chars_result r = from_chars(first, last, parsed);
+    return r.ec == errc() && r.ptr == last && parsed == i && first != last && (*first != '0' || last - first == 1);
+}
+
+void PlayerPool::setName(int i, string_view name) {
+    // the implicit name needs no storage
+    if (isImplicitName(name, i)) {
+        if (!name_ids.empty()) name_ids[i] = 0;
+        return;
+    }
+    if (name_ids.empty()) name_ids.assign(count, 0);
+    name_ids[i] = custom_names.intern(name);
+}
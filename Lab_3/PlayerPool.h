@@ -0,0 +1,76 @@
+#ifndef PLAYERPOOL_H
+#define PLAYERPOOL_H
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Checkpoint.h"
+#include "NameTable.h"
+using namespace std;
+
+// Structure-of-arrays storage for every player in a Game.
+// Combat and leveling only touch the hot columns. Names are implicit
+// ("NPC_<index>", formatted only when asked for); custom names are interned
+// and the per-player id column only exists once the first one is set.
+// The four hot columns share one arena allocation: reserve() sizes it once,
+// clear() just rewinds it, and the whole arena is freed in one delete.
+class PlayerPool {
+public:
+    PlayerPool();
+    PlayerPool(const PlayerPool& other);
+    PlayerPool(PlayerPool&& other) noexcept; // leaves other empty, with no arena
+    PlayerPool& operator=(PlayerPool other); // copy or move, then swap
+    void swap(PlayerPool& other) noexcept;
+
+    int  add();                     // default NPC_<index>, returns its index
+                                    // (every add throws length_error once INT_MAX are in)
+    int  add(const string& name, int hits_taken, float luck, float exp, int level);
+    int  append(int n);             // n rows with implicit names, stats left to the caller; first index
+    void truncate(int n);           // drop every player from index n on
+    int  size() const { return count; }
+    int  capacity() const { return cap; }
+    void reserve(int n);            // room for n players without reallocating
+    void clear();                   // drop every player, keep the arena
+    void save(CheckpointWriter& out) const; // columns go out by reference
+    void load(CheckpointReader& in); // replaces every player; check in.ok()
+
+    // hot columns
+    int&   hitsTaken(int i)       { return hits_taken[i]; }
+    int    hitsTaken(int i) const { return hits_taken[i]; }
+    float& luckOf(int i)          { return luck[i]; }
+    float  luckOf(int i) const    { return luck[i]; }
+    float& expOf(int i)           { return exp[i]; }
+    float  expOf(int i) const     { return exp[i]; }
+    int&   levelOf(int i)         { return level[i]; }
+    int    levelOf(int i) const   { return level[i]; }
+
+    // cold column
+    string nameOf(int i) const;
+    void   appendName(string& out, int i) const; // no temporary string
+    size_t nameLength(int i) const; // nameOf(i).size(), nothing formatted
+    char*  putName(char* dst, int i) const; // nameLength(i) bytes at dst, returns the end
+    void   setName(int i, string_view name);
+    bool   hasCustomName(int i) const { return !name_ids.empty() && name_ids[i] != 0; }
+    static bool isImplicitName(string_view name, int i); // name is exactly NPC_<i>
+
+private:
+    void grow(int more);            // room for `more` rows; throws length_error past INT_MAX
+
+    struct ArenaDelete {
+        void operator()(char* p) const { ::operator delete[](p, align_val_t(64)); }
+    };
+    unique_ptr<char[], ArenaDelete> arena; // 64-byte aligned
+    int*           hits_taken;
+    float*         luck;
+    float*         exp;
+    int*           level;
+    int            count;
+    int              cap;
+    vector<uint32_t> name_ids;      // empty while every name is implicit
+    NameTable        custom_names;
+};
+
+#endif
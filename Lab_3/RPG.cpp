@@ -1,57 +1,69 @@
 #include "RPG.h"
 #include <iostream>
-#include <random>
+#include "Stats.h"
 using namespace std;
 
-static mt19937 RNG(random_device{}());
-//default constructor
-RPG::RPG()
-    : name("NPC"), hits_taken(0), luck(0.1), exp(0.0), level(1) {}
-//overloaded constructor
-RPG::RPG(string n, int h, float l, float e, int lv)
-    : name(n), hits_taken(h), luck(l), exp(e), level(lv) {}
-//deconstructor to save memory
-RPG::~RPG() {}
+//handle constructor, the row itself lives in the pool
+template <class Rules>
+BasicRPG<Rules>::BasicRPG(PlayerPool* p, int i)
+    : pool(p), id(i) {}
 
 //Mutators
-void RPG::setHitsTaken(int new_hits) { hits_taken = new_hits; }
-void RPG::setName(const string& new_name) { name = new_name; }
+template <class Rules>
+void BasicRPG<Rules>::setHitsTaken(int new_hits) { pool->hitsTaken(id) = new_hits; }
+template <class Rules>
+void BasicRPG<Rules>::setName(const string& new_name) { pool->setName(id, new_name); }
 
-bool RPG::isAlive() const { return hits_taken < MAX_HITS_TAKEN; }
+template <class Rules>
+bool BasicRPG<Rules>::isAlive() const { return pool->hitsTaken(id) < Rules::MAX_HITS_TAKEN; }
 
-void RPG::updateExpLevel() {
-    exp += 50.0;
-    if (exp >= 100.0) {
+template <class Rules>
+void BasicRPG<Rules>::updateExpLevel() {
+    float& exp = pool->expOf(id);
+    exp += Rules::EXP_PER_WIN;
+    if (exp >= Rules::EXP_PER_LEVEL) {
         exp = 0.0;
-        level += 1;
-        luck += 0.1;
+        pool->levelOf(id) += 1;
+        pool->luckOf(id) += Rules::LUCK_PER_LEVEL;
+        LAB3_COUNT(STAT_LEVEL_UPS, 1);
     }
 }
 
-void RPG::attack(RPG* opponent) {
-    uniform_real_distribution<float> dis(0.0, 1.0);  // float in [0,1)
-    float r = dis(RNG);
+template <class Rules>
+void BasicRPG<Rules>::attack(BasicRPG opponent, GameRng& rng) {
+    attack(opponent, uniformFloat(rng));  // float in [0,1)
+}
 
+template <class Rules>
+void BasicRPG<Rules>::attack(BasicRPG opponent, float r) {
     // higher opponent luck ⇒ harder to land a hit
-    bool hit = (r > (HIT_FACTOR * opponent->getLuck()));
+    bool hit = (r > (Rules::HIT_FACTOR * opponent.getLuck()));
+    LAB3_COUNT(STAT_ATTACKS, 1);
+    LAB3_COUNT(hit ? STAT_HITS : STAT_MISSES, 1);
     if (hit) {
-        opponent->setHitsTaken(opponent->getHitsTaken() + 1);
+        opponent.setHitsTaken(opponent.getHitsTaken() + 1);
     }
 }
 
-void RPG::printStats() const {
-    cout << "Name: " << name
-         << "   Hits Taken: " << hits_taken
-         << "   Luck: " << luck
-         << "   Exp: " << exp
-         << "   Level: " << level
+template <class Rules>
+void BasicRPG<Rules>::printStats() const {
+    cout << "Name: " << getName()
+         << "   Hits Taken: " << getHitsTaken()
+         << "   Luck: " << getLuck()
+         << "   Exp: " << getExp()
+         << "   Level: " << getLevel()
          << "   Status: " << (isAlive() ? "Alive" : "Dead")
          << '\n';
 }
 
 // accessors
-string RPG::getName() const      { return name; }
-int    RPG::getHitsTaken() const { return hits_taken; }
-float  RPG::getLuck() const      { return luck; }
-float  RPG::getExp() const       { return exp; }
-int    RPG::getLevel() const     { return level; }
+template <class Rules> string BasicRPG<Rules>::getName() const      { return pool->nameOf(id); }
+template <class Rules> void   BasicRPG<Rules>::appendName(string& out) const { pool->appendName(out, id); }
+template <class Rules> int    BasicRPG<Rules>::getHitsTaken() const { return pool->hitsTaken(id); }
+template <class Rules> float  BasicRPG<Rules>::getLuck() const      { return pool->luckOf(id); }
+template <class Rules> float  BasicRPG<Rules>::getExp() const       { return pool->expOf(id); }
+template <class Rules> int    BasicRPG<Rules>::getLevel() const     { return pool->levelOf(id); }
+template <class Rules> int    BasicRPG<Rules>::getId() const        { return id; }
+
+#define LAB3_INSTANTIATE_RPG(R) template class BasicRPG<R>;
+LAB3_FOR_EACH_RULES(LAB3_INSTANTIATE_RPG)
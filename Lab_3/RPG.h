@@ -2,21 +2,23 @@
 #define RPG_H
 
 #include <string>
+#include "PlayerPool.h"
+#include "Rng.h"
+#include "Rules.h"
 using namespace std;
 
-const float HIT_FACTOR     = 0.05;  // affects chance to hit (vs opponent luck)
-const int   MAX_HITS_TAKEN = 3;      // 3 hits = KO
-
-class RPG {
+// Lightweight handle to one player's row in a PlayerPool (cheap to copy).
+// Rules supplies the combat and leveling constants; RPG is the classic set.
+template <class Rules>
+class BasicRPG {
 public:
-    RPG();  // default NPC
-    RPG(string name, int hits_taken, float luck, float exp, int level);
-    ~RPG();
+    BasicRPG(PlayerPool* pool, int id);
 
     // actions
-    void  attack(RPG* opponent);   // attempt to hit opponent
+    void  attack(BasicRPG opponent, GameRng& rng); // attempt to hit opponent
+    void  attack(BasicRPG opponent, float r);      // same, with a pre-drawn roll in [0,1)
     void  printStats() const;      // print stats
-    void  updateExpLevel();        // +50 exp, level up at 100 (then exp -> 0, luck += 0.1)
+    void  updateExpLevel();        // +EXP_PER_WIN, level up at EXP_PER_LEVEL (then exp -> 0, luck up)
 
     // mutators
     void  setHitsTaken(int new_hits);
@@ -25,17 +27,18 @@ public:
     // accessors
     bool  isAlive() const;
     string getName() const;
+    void   appendName(string& out) const; // getName without the temporary
     int    getHitsTaken() const;
     float  getLuck() const;
     float  getExp() const;
     int    getLevel() const;
+    int    getId() const;
 
 private:
-    string name;
-    int    hits_taken;
-    float  luck;
-    float  exp;
-    int    level;
+    PlayerPool* pool;
+    int         id;
 };
 
+typedef BasicRPG<ClassicRules> RPG;
+
 #endif
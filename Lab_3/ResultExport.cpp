@@ -0,0 +1,337 @@
+#include "ResultExport.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Parallel.h"
+using namespace std;
+
+static const char     COLUMNS_MAGIC[4] = { 'L', '3', 'R', 'C' };
+static const uint32_t BYTE_ORDER_MARK  = 0x01020304;
+static const int      COLUMN_COUNT     = 7;
+static const size_t   HEADER_BYTES     = 4 + 4 + 4 + 4 + 8 + 8 * COLUMN_COUNT;
+static const size_t   WRITE_BYTES      = 1 << 20;
+
+static bool writeAll(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t done = ::write(fd, p, n);
+        if (done < 0 && errno == EINTR) continue;
+        if (done <= 0) return false;
+        p += done;
+        n -= done;
+    }
+    return true;
+}
+
+static size_t align64(size_t v) { return (v + 63) & ~(size_t)63; }
+
+ResultExporter::ResultExporter(int t) : threads(t > 0 ? t : defaultThreads()) {}
+
+bool ResultExporter::write(const PlayerPool& pool, int max_hits, ExportFormat format, const string& path) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool written = (format == ExportFormat::Columnar) ? writeColumns(pool, max_hits, fd)
+                                                     : writeText(pool, max_hits, format, fd);
+    if (::close(fd) != 0) written = false;
+    return written;
+}
+
+// ---- text ------------------------------------------------------------------
+
+// Room for one row besides its name: three ints of up to 11 characters,
+// two floats of up to 16 (FloatText copies 16) and the JSON keys.
+static const size_t ROW_BYTES = 160;
+
+template <size_t N>
+static char* putLiteral(char* p, const char (&s)[N]) {
+    memcpy(p, s, N - 1);
+    return p + N - 1;
+}
+
+static char* putNumber(char* p, int v) { return to_chars(p, p + 11, v).ptr; }
+
+// Shortest round-trip digits of recently seen floats, by bit pattern. Luck
+// and exp move in steps of LUCK_PER_LEVEL and EXP_PER_WIN, so a column has
+// few distinct values and most rows are a 16-byte copy.
+class FloatText {
+public:
+    FloatText() { for (Slot& s : slots) s.len = 0; }  // every float needs at least 1 char
+
+    char* put(char* p, float v) {
+        uint32_t bits;
+        memcpy(&bits, &v, 4);
+        Slot& s = slots[(bits * 0x9E3779B1u) >> 26];
+        if (s.len == 0 || s.bits != bits) {
+            s.bits = bits;
+            s.len = (uint8_t)(to_chars(s.text, s.text + sizeof s.text, v).ptr - s.text);
+        }
+        memcpy(p, s.text, sizeof s.text);
+        return p + s.len;
+    }
+
+private:
+    struct Slot {
+        uint32_t bits;
+        uint8_t  len;
+        char     text[16];
+    };
+    Slot slots[64];
+};
+
+// RFC 4180: quoted only when it has to be, quotes doubled
+static char* putCsvName(char* p, const string& name) {
+    if (name.find_first_of(",\"\r\n") == string::npos) {
+        memcpy(p, name.data(), name.size());
+        return p + name.size();
+    }
+    *p++ = '"';
+    for (char c : name) {
+        if (c == '"') *p++ = '"';
+        *p++ = c;
+    }
+    *p++ = '"';
+    return p;
+}
+
+static char* putJsonName(char* p, const string& name) {
+    static const char HEX[] = "0123456789abcdef";
+    *p++ = '"';
+    for (unsigned char c : name) {
+        if (c == '"' || c == '\\') {
+            *p++ = '\\';
+            *p++ = (char)c;
+        } else if (c < 0x20) {
+            p = putLiteral(p, "\\u00");
+            *p++ = HEX[c >> 4];
+            *p++ = HEX[c & 15];
+        } else {
+            *p++ = (char)c;
+        }
+    }
+    *p++ = '"';
+    return p;
+}
+
+// Formats rows [first, last) into buf, growing it if a row might not fit,
+// and returns the bytes used. Rows are written through a raw pointer.
+static size_t formatRows(string& buf, const PlayerPool& pool, int max_hits, ExportFormat format,
+                         int first, int last) {
+    FloatText luck, exp;
+    string custom;
+    size_t used = 0;
+    for (int i = first; i < last; ++i) {
+        bool named = pool.hasCustomName(i);
+        // a custom name can grow sixfold as JSON (\u00XX escapes)
+        size_t need = ROW_BYTES + (named ? 6 * pool.nameLength(i) + 2 : pool.nameLength(i));
+        if (used + need > buf.size()) buf.resize(max(2 * buf.size(), used + need));
+        char* start = &buf[used];
+        char* p = start;
+        if (named) {
+            custom.clear();
+            pool.appendName(custom, i);
+        }
+        bool alive = pool.hitsTaken(i) < max_hits;
+        if (format == ExportFormat::Csv) {
+            p = named ? putCsvName(p, custom) : pool.putName(p, i);
+            *p++ = ',';
+            p = putNumber(p, pool.hitsTaken(i));
+            *p++ = ',';
+            p = luck.put(p, pool.luckOf(i));
+            *p++ = ',';
+            p = exp.put(p, pool.expOf(i));
+            *p++ = ',';
+            p = putNumber(p, pool.levelOf(i));
+            p = alive ? putLiteral(p, ",1\n") : putLiteral(p, ",0\n");
+        } else {
+            p = putLiteral(p, "{\"name\":");
+            if (named) {
+                p = putJsonName(p, custom);
+            } else {
+                *p++ = '"';
+                p = pool.putName(p, i);
+                *p++ = '"';
+            }
+            p = putLiteral(p, ",\"hits_taken\":");
+            p = putNumber(p, pool.hitsTaken(i));
+            p = putLiteral(p, ",\"luck\":");
+            p = luck.put(p, pool.luckOf(i));
+            p = putLiteral(p, ",\"exp\":");
+            p = exp.put(p, pool.expOf(i));
+            p = putLiteral(p, ",\"level\":");
+            p = putNumber(p, pool.levelOf(i));
+            p = alive ? putLiteral(p, ",\"alive\":true}\n") : putLiteral(p, ",\"alive\":false}\n");
+        }
+        used += p - start;
+    }
+    return used;
+}
+
+// Slices are sized to come out near WRITE_BYTES. Each wave formats one
+// slice per thread, then writes them in order while nothing else runs;
+// formatting is the slow part, so there is little to gain from overlapping.
+bool ResultExporter::writeText(const PlayerPool& pool, int max_hits, ExportFormat format, int fd) {
+    const int  slice_rows = (format == ExportFormat::Csv) ? 1 << 15 : 1 << 14;
+    const int  rows = pool.size();
+    const long long slice_count = (rows + slice_rows - 1) / slice_rows;
+    slices.resize(threads);
+    vector<size_t> used(threads);
+    string header = (format == ExportFormat::Csv) ? "name,hits_taken,luck,exp,level,alive\n" : "";
+    if (!writeAll(fd, header.data(), header.size())) return false;
+    for (long long wave = 0; wave < slice_count; wave += threads) {
+        long long n = min<long long>(threads, slice_count - wave);
+        parallelFor(n, threads, 1, [&](long long begin, long long end, int) {
+            for (long long k = begin; k < end; ++k) {
+                int first = (int)((wave + k) * slice_rows);
+                used[k] = formatRows(slices[k], pool, max_hits, format, first, min(rows, first + slice_rows));
+            }
+        });
+        for (long long k = 0; k < n; ++k) {
+            if (!writeAll(fd, slices[k].data(), used[k])) return false;
+        }
+    }
+    return true;
+}
+
+// ---- columns ---------------------------------------------------------------
+
+// Buffers column bytes and writes each megabyte as it fills.
+class ColumnOut {
+public:
+    ColumnOut(int f, string& b) : fd(f), buf(b), offset(0), failed(false) { buf.clear(); }
+
+    char* room(size_t bytes) {      // bytes to fill, contiguous
+        if (buf.size() + bytes > WRITE_BYTES) spill();
+        size_t at = buf.size();
+        buf.resize(at + bytes);
+        offset += bytes;
+        return &buf[at];
+    }
+    void put(const void* p, size_t bytes) { memcpy(room(bytes), p, bytes); }
+    void padTo(size_t to) { memset(room(to - offset), 0, to - offset); }
+    bool finish() { spill(); return !failed; }
+
+private:
+    void spill() {
+        if (!failed && !writeAll(fd, buf.data(), buf.size())) failed = true;
+        buf.clear();
+    }
+
+    int     fd;
+    string& buf;
+    size_t  offset;                 // file offset of the next byte
+    bool    failed;
+};
+
+// fills a column a block of rows at a time: value(i) for every row
+template <class T, class F>
+static void putColumn(ColumnOut& out, int rows, F value) {
+    const int block = (int)(WRITE_BYTES / sizeof(T) / 4);
+    for (int first = 0; first < rows; first += block) {
+        int n = min(block, rows - first);
+        T* dst = (T*)out.room(n * sizeof(T));
+        for (int i = 0; i < n; ++i) {
+            T v = value(first + i);
+            memcpy(dst + i, &v, sizeof v);
+        }
+    }
+}
+
+bool ResultExporter::writeColumns(const PlayerPool& pool, int max_hits, int fd) {
+    const int rows = pool.size();
+    uint64_t offsets[COLUMN_COUNT];
+    const size_t sizes[COLUMN_COUNT - 1] = { 4, 4, 4, 4, 1, 8 }; // per row, names aside
+    size_t at = align64(HEADER_BYTES);
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        offsets[c] = at;
+        if (c < COLUMN_COUNT - 1) at = align64(at + sizes[c] * (rows + (c == 5 ? 1 : 0)));
+    }
+
+    slices.resize(max((int)slices.size(), 1));
+    ColumnOut out(fd, slices[0]);
+    uint32_t zero = 0;
+    uint64_t count = rows;
+    out.put(COLUMNS_MAGIC, 4);
+    out.put(&RESULT_COLUMNS_VERSION, 4);
+    out.put(&BYTE_ORDER_MARK, 4);
+    out.put(&zero, 4);
+    out.put(&count, 8);
+    out.put(offsets, sizeof offsets);
+
+    out.padTo(offsets[0]);
+    putColumn<int32_t>(out, rows, [&](int i) { return (int32_t)pool.hitsTaken(i); });
+    out.padTo(offsets[1]);
+    putColumn<float>(out, rows, [&](int i) { return pool.luckOf(i); });
+    out.padTo(offsets[2]);
+    putColumn<float>(out, rows, [&](int i) { return pool.expOf(i); });
+    out.padTo(offsets[3]);
+    putColumn<int32_t>(out, rows, [&](int i) { return (int32_t)pool.levelOf(i); });
+    out.padTo(offsets[4]);
+    putColumn<uint8_t>(out, rows, [&](int i) { return (uint8_t)(pool.hitsTaken(i) < max_hits); });
+    out.padTo(offsets[5]);
+    uint64_t name_at = 0;
+    putColumn<uint64_t>(out, rows + 1, [&](int i) {
+        uint64_t start = name_at;
+        if (i < rows) name_at += pool.nameLength(i);
+        return start;
+    });
+    out.padTo(offsets[6]);
+    for (int i = 0; i < rows; ++i) pool.putName(out.room(pool.nameLength(i)), i);
+    return out.finish();
+}
+
+// ---- reader ----------------------------------------------------------------
+
+ResultColumns::ResultColumns(const string& path) : data(nullptr), size(0), count(0), offsets() {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_BYTES) {
+        ::close(fd);
+        return;
+    }
+    void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) return;
+    const uint8_t* p = (const uint8_t*)m;
+    size_t n = st.st_size;
+    uint32_t version, mark;
+    uint64_t rows;
+    memcpy(&version, p + 4, 4);
+    memcpy(&mark, p + 8, 4);
+    memcpy(&rows, p + 16, 8);
+    memcpy(offsets, p + 24, sizeof offsets);
+
+    // every column must lie inside the file, names included
+    const size_t sizes[COLUMN_COUNT - 1] = { 4, 4, 4, 4, 1, 8 };
+    bool valid = memcmp(p, COLUMNS_MAGIC, 4) == 0 && version == RESULT_COLUMNS_VERSION &&
+                 mark == BYTE_ORDER_MARK && rows < (1ULL << 40);
+    for (int c = 0; valid && c < COLUMN_COUNT - 1; ++c) {
+        uint64_t bytes = sizes[c] * (rows + (c == 5 ? 1 : 0));
+        valid = offsets[c] % 64 == 0 && offsets[c] <= n && bytes <= n - offsets[c];
+    }
+    if (valid) {
+        uint64_t names;
+        memcpy(&names, p + offsets[5] + 8 * rows, 8);
+        valid = offsets[6] <= n && names <= n - offsets[6];
+    }
+    if (!valid) {
+        munmap(m, n);
+        return;
+    }
+    data = p;
+    size = n;
+    count = (long long)rows;
+}
+
+ResultColumns::~ResultColumns() {
+    if (data) munmap((void*)data, size);
+}
+
+string_view ResultColumns::name(long long i) const {
+    const uint64_t* at = (const uint64_t*)column(5);
+    return string_view((const char*)column(6) + at[i], at[i + 1] - at[i]);
+}
@@ -0,0 +1,72 @@
+#ifndef RESULTEXPORT_H
+#define RESULTEXPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "PlayerPool.h"
+using namespace std;
+
+// Final results, one row per player: name, hits taken, luck, exp, level, alive.
+enum class ExportFormat {
+    Csv,          // header line, then name,hits_taken,luck,exp,level,alive (alive 0/1)
+    Ndjson,       // one JSON object per line, same fields, alive true/false
+    Columnar      // binary columns for ResultColumns, see below
+};
+
+// Columnar file layout:
+//   header   "L3RC", u32 version, u32 byte-order mark, u32 0, u64 rows,
+//            u64 file offset of each column in the order below
+//   columns  i32 hits taken, f32 luck, f32 exp, i32 level, u8 alive,
+//            u64 name offsets (rows + 1), name bytes
+// Every column starts on a 64-byte boundary and is in host byte order, so
+// a reader maps the file and uses the columns as arrays in place.
+const uint32_t RESULT_COLUMNS_VERSION = 1;
+
+// Writes the text formats from parallel slices of rows: each slice is
+// formatted with to_chars into its own reusable buffer of about a
+// megabyte, and the buffers go out in row order, one write() each. Floats
+// are written in their shortest round-trip form.
+class ResultExporter {
+public:
+    explicit ResultExporter(int threads = 0); // 0 = every core
+
+    // alive means hits taken < max_hits_taken, as printFinalResults has it
+    bool write(const PlayerPool& pool, int max_hits_taken, ExportFormat format, const string& path);
+
+private:
+    bool writeText(const PlayerPool& pool, int max_hits_taken, ExportFormat format, int fd);
+    bool writeColumns(const PlayerPool& pool, int max_hits_taken, int fd);
+
+    int            threads;
+    vector<string> slices;          // one buffer per slice in flight
+};
+
+// Read-only view of a Columnar export. Nothing is parsed: the file is
+// mapped and the accessors point into it.
+class ResultColumns {
+public:
+    explicit ResultColumns(const string& path);
+    ~ResultColumns();
+
+    bool           ok() const { return data != nullptr; }
+    long long      rows() const { return count; }
+    const int32_t* hitsTaken() const { return (const int32_t*)column(0); }
+    const float*   luck() const { return (const float*)column(1); }
+    const float*   exp() const { return (const float*)column(2); }
+    const int32_t* level() const { return (const int32_t*)column(3); }
+    const uint8_t* alive() const { return column(4); }
+    string_view    name(long long i) const;
+
+private:
+    const uint8_t* column(int c) const { return data + offsets[c]; }
+
+    const uint8_t* data;
+    size_t         size;
+    long long      count;
+    uint64_t       offsets[7];
+};
+
+#endif
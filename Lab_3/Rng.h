@@ -0,0 +1,88 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <random>
+using namespace std;
+
+// splitmix64 step, used to expand one seed into engine state
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256++ (Blackman & Vigna), usable with <random> distributions
+class Xoshiro256pp {
+public:
+    typedef uint64_t result_type;
+
+    explicit Xoshiro256pp(uint64_t seed = 1) { this->seed(seed); }
+
+    void seed(uint64_t seed) {
+        uint64_t sm = seed;
+        for (int i = 0; i < 4; ++i) s[i] = splitmix64(sm);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // state as text, like the standard engines, so checkpoints treat both alike
+    friend ostream& operator<<(ostream& out, const Xoshiro256pp& e) {
+        return out << e.s[0] << ' ' << e.s[1] << ' ' << e.s[2] << ' ' << e.s[3];
+    }
+    friend istream& operator>>(istream& in, Xoshiro256pp& e) {
+        return in >> e.s[0] >> e.s[1] >> e.s[2] >> e.s[3];
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t s[4];
+};
+
+// engine used by Game and RPG::attack; build with -DLAB3_FAST_RNG for xoshiro
+#ifdef LAB3_FAST_RNG
+typedef Xoshiro256pp GameRng;
+#else
+typedef mt19937 GameRng;
+#endif
+
+// Seeds an engine from all 64 bits. A seed that fits in 32 bits seeds
+// mt19937 directly, as it always has, so existing runs replay unchanged;
+// a wider one goes through seed_seq so both halves count.
+inline void seedEngine(GameRng& rng, uint64_t seed) {
+#ifdef LAB3_FAST_RNG
+    rng.seed(seed);
+#else
+    if (seed <= 0xFFFFFFFFULL) {
+        rng.seed((uint32_t)seed);
+        return;
+    }
+    seed_seq seq{ (uint32_t)seed, (uint32_t)(seed >> 32) };
+    rng.seed(seq);
+#endif
+}
+
+// float in [0,1) for one attack roll
+inline float uniformFloat(GameRng& rng) {
+    return uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+}
+
+#endif
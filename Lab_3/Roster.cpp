@@ -0,0 +1,200 @@
+#include "Roster.h"
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Parallel.h"
+using namespace std;
+
+static const size_t CHUNK_BYTES = 4 << 20;
+static const char   HEADER[] = "name,";
+
+// first byte of the line after the one holding p
+static const char* nextLine(const char* p, const char* end) {
+    const char* nl = (const char*)memchr(p, '\n', end - p);
+    return nl ? nl + 1 : end;
+}
+
+static bool isBlank(const char* line, const char* eol) {
+    return eol == line || (eol - line == 1 && *line == '\r');
+}
+
+// One slice of the file, whole lines only.
+struct RosterChunk {
+    struct Named {
+        int         row;
+        string_view name;           // into the mapping, or into quoted
+    };
+
+    const char*   begin;
+    const char*   end;
+    int           first_row;
+    int           rows;
+    const char*   bad;              // first malformed line, nullptr if none
+    vector<Named> names;            // rows whose name is not the implicit one
+    deque<string> quoted;           // unescaped quoted names, addresses stable
+};
+
+// one number and the comma after it (or the end of the line for the last)
+template <class T>
+static bool field(const char*& p, const char* eol, T& v, bool last) {
+    from_chars_result r = from_chars(p, eol, v);
+    if (r.ec != errc() || r.ptr == p) return false;
+    if (r.ptr != eol && *r.ptr != ',') return false;
+    if (!last && r.ptr == eol) return false;
+    p = r.ptr + 1;
+    return true;
+}
+
+// Parses [p, eol) into pool row `row`. Quoted names follow RFC 4180.
+static bool parseRow(const char* p, const char* eol, PlayerPool& pool, int row, RosterChunk& c) {
+    if (eol[-1] == '\r') --eol;
+    string_view name;
+    if (*p == '"') {
+        string s;
+        for (++p;; ++p) {
+            if (p == eol) return false;
+            if (*p == '"') {
+                if (p + 1 == eol || p[1] != '"') break;
+                ++p;
+            }
+            s += *p;
+        }
+        ++p;
+        c.quoted.push_back(move(s));
+        name = c.quoted.back();
+    } else {
+        const char* comma = (const char*)memchr(p, ',', eol - p);
+        if (!comma) return false;
+        name = string_view(p, comma - p);
+        p = comma;
+    }
+    if (name.empty() || p == eol || *p != ',') return false;
+    ++p;
+
+    int hits, level;
+    float luck, exp;
+    if (!field(p, eol, hits, false) || !field(p, eol, luck, false) ||
+        !field(p, eol, exp, false) || !field(p, eol, level, true)) {
+        return false;
+    }
+    if (hits < 0 || level < 1 || !(luck >= 0.0f) || !(exp >= 0.0f) || isinf(luck) || isinf(exp)) {
+        return false;
+    }
+    pool.hitsTaken(row) = hits;
+    pool.luckOf(row) = luck;
+    pool.expOf(row) = exp;
+    pool.levelOf(row) = level;
+    if (!PlayerPool::isImplicitName(name, row)) c.names.push_back({ row, name });
+    return true;
+}
+
+RosterLoader::RosterLoader(int t) : threads(t > 0 ? t : defaultThreads()) {}
+
+bool RosterLoader::load(PlayerPool& pool, const string& path) {
+    why.clear();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        why = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        why = "cannot read " + path;
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+    void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+        why = "cannot map " + path;
+        return false;
+    }
+    madvise(m, st.st_size, MADV_WILLNEED);
+    const char* data = (const char*)m;
+    const char* end = data + st.st_size;
+
+    const char* body = data;
+    if ((size_t)st.st_size >= sizeof HEADER - 1 && memcmp(data, HEADER, sizeof HEADER - 1) == 0) {
+        body = nextLine(data, end);
+    }
+    vector<RosterChunk> chunks;
+    for (const char* at = body; at < end;) {
+        const char* stop = ((size_t)(end - at) > CHUNK_BYTES) ? nextLine(at + CHUNK_BYTES - 1, end) : end;
+        chunks.push_back(RosterChunk());
+        chunks.back().begin = at;
+        chunks.back().end = stop;
+        at = stop;
+    }
+
+    // pass 1: rows per chunk, then each chunk's first pool index
+    parallelFor(chunks.size(), threads, 1, [&](long long begin, long long end_chunk, int) {
+        for (long long k = begin; k < end_chunk; ++k) {
+            RosterChunk& c = chunks[k];
+            int rows = 0;
+            for (const char* line = c.begin; line < c.end;) {
+                const char* next = nextLine(line, c.end);
+                const char* eol = (next[-1] == '\n') ? next - 1 : next;
+                if (!isBlank(line, eol)) ++rows;
+                line = next;
+            }
+            c.rows = rows;
+        }
+    });
+    long long total = 0;
+    for (RosterChunk& c : chunks) {
+        c.first_row = (int)(pool.size() + total);
+        total += c.rows;
+    }
+    if (pool.size() + total > INT_MAX) {
+        munmap(m, st.st_size);
+        why = path + ": too many players";
+        return false;
+    }
+
+    // pass 2: parse straight into the columns
+    int first = pool.append((int)total);
+    parallelFor(chunks.size(), threads, 1, [&](long long begin, long long end_chunk, int) {
+        for (long long k = begin; k < end_chunk; ++k) {
+            RosterChunk& c = chunks[k];
+            int row = c.first_row;
+            c.bad = nullptr;
+            for (const char* line = c.begin; line < c.end;) {
+                const char* next = nextLine(line, c.end);
+                const char* eol = (next[-1] == '\n') ? next - 1 : next;
+                if (!isBlank(line, eol) && !parseRow(line, eol, pool, row++, c)) {
+                    c.bad = line;
+                    break;
+                }
+                line = next;
+            }
+        }
+    });
+
+    for (const RosterChunk& c : chunks) {
+        if (!c.bad) continue;
+        long long line = 1;
+        for (const char* p = data; (p = (const char*)memchr(p, '\n', c.bad - p)) != nullptr; ++p) ++line;
+        munmap(m, st.st_size);
+        pool.truncate(first);
+        why = path + ":" + to_string(line) + ": expected name,hits_taken,luck,exp,level";
+        return false;
+    }
+
+    // interning is the one serial step, and only for custom names
+    for (const RosterChunk& c : chunks) {
+        for (const RosterChunk::Named& n : c.names) pool.setName(n.row, n.name);
+    }
+    munmap(m, st.st_size);
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef ROSTER_H
+#define ROSTER_H
+
+#include <string>
+#include "PlayerPool.h"
+using namespace std;
+
+// Roster file: one player per line,
+//   name,hits_taken,luck,exp,level
+// Anything after a sixth comma is ignored and a first line starting with
+// "name," is a header, so a Csv export (ResultExport.h) loads as it is.
+// Names are quoted as in that export when they hold a comma or a quote;
+// they cannot hold a line break. Blank lines are skipped, \r\n is fine.
+//
+// The file is mapped and cut into chunks at line boundaries. One parallel
+// pass counts each chunk's rows, so every chunk knows its first pool index;
+// a second parses its chunk with from_chars straight into the pool columns.
+// Only names other than the implicit NPC_<index> are kept aside, to be
+// interned on one thread at the end.
+class RosterLoader {
+public:
+    explicit RosterLoader(int threads = 0); // 0 = every core
+
+    // Appends every player in the file to pool. On failure nothing is added
+    // and error() says why (with the line for a malformed row).
+    bool          load(PlayerPool& pool, const string& path);
+    const string& error() const { return why; }
+
+private:
+    int    threads;
+    string why;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <string>
+using namespace std;
+
+// Rule sets. Each one is a policy type with constexpr members, so a
+// BasicGame<Rules> / BasicRPG<Rules> instantiation sees the numbers as
+// compile-time constants (the duel loops unroll, the hit threshold folds).
+
+struct ClassicRules {
+    static constexpr const char* NAME   = "classic";
+    static constexpr float HIT_FACTOR     = 0.05f;  // affects chance to hit (vs opponent luck)
+    static constexpr int   MAX_HITS_TAKEN = 3;      // 3 hits = KO
+    static constexpr float EXP_PER_WIN    = 50.0f;
+    static constexpr float EXP_PER_LEVEL  = 100.0f; // then exp -> 0, luck += LUCK_PER_LEVEL
+    static constexpr float LUCK_PER_LEVEL = 0.1f;
+};
+
+// one clean hit ends it
+struct SuddenDeathRules : ClassicRules {
+    static constexpr const char* NAME   = "sudden-death";
+    static constexpr int   MAX_HITS_TAKEN = 1;
+};
+
+// long fights where luck counts for more
+struct EnduranceRules : ClassicRules {
+    static constexpr const char* NAME   = "endurance";
+    static constexpr float HIT_FACTOR     = 0.15f;
+    static constexpr int   MAX_HITS_TAKEN = 6;
+    static constexpr float EXP_PER_WIN    = 25.0f;
+};
+
+// Every rule set built into the binary; templates are explicitly
+// instantiated once per entry (see the bottom of RPG.cpp, Duel.cpp, Game.cpp).
+#define LAB3_FOR_EACH_RULES(X) \
+    X(ClassicRules)            \
+    X(SuddenDeathRules)        \
+    X(EnduranceRules)
+
+// Runtime dispatch: calls f(Rules()) for the rule set called `name`.
+// Returns false if there is no such rule set.
+template <class F>
+bool withRules(const string& name, F f) {
+    if (name == ClassicRules::NAME)     { f(ClassicRules());     return true; }
+    if (name == SuddenDeathRules::NAME) { f(SuddenDeathRules()); return true; }
+    if (name == EnduranceRules::NAME)   { f(EnduranceRules());   return true; }
+    return false;
+}
+
+inline const char* rulesNames() { return "classic, sudden-death, endurance"; }
+
+#endif
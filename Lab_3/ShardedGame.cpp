@@ -0,0 +1,91 @@
+#include "ShardedGame.h"
+#include <climits>
+#include <string>
+#include "MonteCarloRunner.h"
+#include "Parallel.h"
+#include "Stats.h"
+using namespace std;
+
+template <class Rules>
+BasicShardedGame<Rules>::BasicShardedGame(unsigned s, int sh, int t)
+    : seed(s), shards(sh), threads(t <= 0 ? defaultThreads() : t),
+      matchmaking(Matchmaking::Uniform), liveness(Liveness::Packed), final_game(s) {
+    if (shards <= 0) shards = threads;
+}
+
+template <class Rules> void BasicShardedGame<Rules>::setMatchmaking(Matchmaking m) { matchmaking = m; }
+template <class Rules> void BasicShardedGame<Rules>::setLiveness(Liveness l) { liveness = l; }
+template <class Rules> void BasicShardedGame<Rules>::setEventSink(EventSink& s) { final_game.setEventSink(s); }
+
+template <class Rules>
+long long BasicShardedGame<Rules>::globalIndex(int final_index) const { return finalists[final_index]; }
+
+template <class Rules>
+long long BasicShardedGame<Rules>::getChampion() const {
+    int c = final_game.getChampion();
+    return c < 0 ? -1 : finalists[c];
+}
+
+template <class Rules>
+long long BasicShardedGame<Rules>::getRound() const {
+    long long total = final_game.getRound();
+    for (const Champion& c : champions) total += c.rounds;
+    return total;
+}
+
+// one per thread, cache-line aligned so neighbours never share a line;
+// the Game is built on first use, on the thread that plays it
+template <class Rules>
+struct alignas(64) ShardWorker {
+    unique_ptr<BasicGame<Rules> > game;
+};
+
+template <class Rules>
+void BasicShardedGame<Rules>::play(long long players) {
+    // no empty shards, and none past what a Game can index
+    long long count = max<long long>(shards, (players + INT_MAX - 1) / INT_MAX);
+    count = min(count, players);
+    champions.assign(count, Champion());
+    vector<ShardWorker<Rules> > workers(threads);
+
+    // map: every shard a whole silent gameLoop
+    parallelFor(count, threads, 1, [&](long long begin, long long end, int w) {
+        unique_ptr<BasicGame<Rules> >& g = workers[w].game;
+        for (long long s = begin; s < end; ++s) {
+            long long first = s * players / count;
+            int n = (int)((s + 1) * players / count - first);
+            if (!g) {
+                g.reset(new BasicGame<Rules>(0u));
+                g->setEventSink(silentSink());
+                g->setReportStats(false);   // one dump after the final instead
+            }
+            g->reset(MonteCarloRunner::gameSeed(seed, s));
+            g->setGameId(s);
+            g->setMatchmaking(matchmaking);
+            g->setLiveness(liveness);
+            g->generatePlayers(n);
+            g->gameLoop();
+
+            Player champ = g->getPlayer(g->getChampion());
+            champions[s] = { first + champ.getId(), champ.getHitsTaken(), champ.getLuck(),
+                             champ.getExp(), champ.getLevel(), g->getRound() };
+        }
+    });
+    workers.clear();                    // shard pools go before the final starts
+
+    // reduce: the champions, in shard order, play the final
+    final_game.reset(MonteCarloRunner::gameSeed(seed, count));
+    final_game.setGameId(count);
+    final_game.setMatchmaking(matchmaking);
+    final_game.setLiveness(liveness);
+    final_game.reserve((int)count);
+    finalists.clear();
+    for (const Champion& c : champions) {
+        final_game.addPlayer("NPC_" + to_string(c.global_index), c.hits_taken, c.luck, c.exp, c.level);
+        finalists.push_back(c.global_index);
+    }
+    final_game.gameLoop();
+}
+
+#define LAB3_INSTANTIATE_SHARDED(R) template class BasicShardedGame<R>;
+LAB3_FOR_EACH_RULES(LAB3_INSTANTIATE_SHARDED)
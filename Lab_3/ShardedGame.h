@@ -0,0 +1,64 @@
+#ifndef SHARDEDGAME_H
+#define SHARDEDGAME_H
+
+#include <memory>
+#include <vector>
+#include "Game.h"
+using namespace std;
+
+// One big tournament played as map-reduce. The population is cut into
+// shards of consecutive players; each shard is a whole gameLoop of its own
+// (map), and the shard champions meet in a final Game (reduce).
+//
+// Shards share nothing while they play: each worker thread builds its Game,
+// generates the shard's players into it and plays it within one task, so
+// the pool is first touched, and so placed, by the thread that uses it.
+// Workers reuse their Game for every shard they draw. Nothing is locked;
+// each shard only writes its own champion slot, read after the join.
+//
+// Shard s plays with seed MonteCarloRunner::gameSeed(seed, s) and game id s,
+// the final with gameSeed(seed, shards) and game id shards, so the outcome
+// depends on the seed and the shard count, never on the thread count.
+template <class Rules>
+class BasicShardedGame {
+public:
+    typedef typename BasicGame<Rules>::Player Player;
+
+    explicit BasicShardedGame(unsigned seed, int shards = 0, int threads = 0); // 0 = one per core
+
+    void setMatchmaking(Matchmaking m); // for shards and final alike
+    void setLiveness(Liveness l);
+    void setEventSink(EventSink& sink); // the final's output; shards are silent
+
+    void play(long long players);   // players NPC_0 .. NPC_<players - 1>, shards then final
+
+    BasicGame<Rules>&       finalGame() { return final_game; }
+    const BasicGame<Rules>& finalGame() const { return final_game; }
+    int       getNumShards() const { return (int)champions.size(); }
+    long long globalIndex(int final_index) const; // whole-population index of a finalist
+    long long getChampion() const;  // whole-population index, -1 until decided
+    long long getRound() const;     // rounds over every shard and the final
+
+private:
+    struct Champion {
+        long long global_index;     // -1 for an empty shard
+        int       hits_taken;
+        float     luck;
+        float     exp;
+        int       level;
+        long long rounds;           // rounds the shard took
+    };
+
+    unsigned         seed;
+    int              shards;
+    int              threads;
+    Matchmaking      matchmaking;
+    Liveness         liveness;
+    vector<Champion> champions;     // one per shard
+    vector<long long> finalists;    // final pool index -> global index
+    BasicGame<Rules> final_game;
+};
+
+typedef BasicShardedGame<ClassicRules> ShardedGame;
+
+#endif
@@ -0,0 +1,228 @@
+#include "SimulationFarm.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "Game.h"
+#include "Parallel.h"
+using namespace std;
+
+static_assert(atomic<long long>::is_always_lock_free && atomic<uint32_t>::is_always_lock_free &&
+              atomic<uint64_t>::is_always_lock_free, "shared-memory atomics must not need a lock");
+
+static const uint32_t BATCH_FREE      = 0;
+static const uint32_t BATCH_DONE      = 0x80000000u; // | the generation that finished it
+static const uint32_t BATCH_ABANDONED = 0xFFFFFFFFu;
+
+static size_t align64(size_t v) { return (v + 63) & ~(size_t)63; }
+
+// Where everything sits in the segment. Histograms are flat long long
+// arrays: games, wins by player, champion levels, player levels.
+struct FarmLayout {
+    int       players;
+    int       levels;               // buckets per level histogram; higher levels land in the last
+    size_t    cells;                // long longs per histogram copy
+    long long batches;
+    long long batch_games;
+    long long games;
+    int       workers;
+    size_t    states_at, slots_at, slot_bytes, bytes;
+    char*     base;
+
+    FarmLayout(int p, long long g, long long b, int w)
+        : players(p), levels(p + 2), cells(1 + p + 2 * (size_t)(p + 2)), batches((g + b - 1) / b),
+          batch_games(b), games(g), workers(w), base(nullptr) {
+        states_at = 64;             // after the cursor's line
+        slots_at = align64(states_at + batches * sizeof(uint32_t));
+        slot_bytes = 64 + align64(2 * cells * sizeof(long long));
+        bytes = slots_at + workers * slot_bytes;
+    }
+
+    atomic<long long>& next() const { return *(atomic<long long>*)base; }
+    atomic<uint32_t>&  state(long long b) const { return ((atomic<uint32_t>*)(base + states_at))[b]; }
+    atomic<uint64_t>&  commit(int w) const { return *(atomic<uint64_t>*)(base + slots_at + w * slot_bytes); }
+    long long*         copy(int w, int c) const {
+        return (long long*)(base + slots_at + w * slot_bytes + 64) + c * cells;
+    }
+    long long          gamesIn(long long b) const { return min(batch_games, games - b * batch_games); }
+};
+
+// A fresh, already unlinked segment: only this process and its children see it.
+static char* mapSegment(size_t bytes) {
+    static atomic<int> made(0);
+    string name = "/lab3-farm-" + to_string(getpid()) + "-" + to_string(made.fetch_add(1));
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return nullptr;
+    shm_unlink(name.c_str());
+    void* m = MAP_FAILED;
+    if (ftruncate(fd, bytes) == 0) m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return m == MAP_FAILED ? nullptr : (char*)m;
+}
+
+// Fresh batches in cursor order; once the cursor is past the end, sweep
+// for batches handed back after a crash. -1 when nothing is left.
+static long long claimBatch(const FarmLayout& lay, uint32_t gen) {
+    for (;;) {
+        long long b = lay.next().fetch_add(1);
+        if (b >= lay.batches) break;
+        uint32_t expected = BATCH_FREE;
+        if (lay.state(b).compare_exchange_strong(expected, gen)) return b;
+    }
+    for (long long b = 0; b < lay.batches; ++b) {
+        uint32_t expected = BATCH_FREE;
+        if (lay.state(b).load(memory_order_relaxed) == BATCH_FREE &&
+            lay.state(b).compare_exchange_strong(expected, gen)) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+static void addCells(long long* dst, const vector<long long>& delta) {
+    for (size_t i = 0; i < delta.size(); ++i) dst[i] += delta[i];
+}
+
+// Runs in the child; never returns to the caller's code.
+template <class Rules>
+static void farmWorker(const FarmLayout& lay, int w, uint32_t gen, unsigned seed) {
+    BasicGame<Rules> g(0u);
+    g.setEventSink(silentSink());
+    g.setReportStats(false);
+    g.reserve(lay.players);
+
+    // a crashed predecessor may have left the spare copy half updated
+    int cur = (int)(lay.commit(w).load(memory_order_acquire) & 1);
+    memcpy(lay.copy(w, 1 - cur), lay.copy(w, cur), lay.cells * sizeof(long long));
+
+    vector<long long> delta(lay.cells);
+    long long* wins = delta.data() + 1;
+    long long* champion_levels = wins + lay.players;
+    long long* player_levels = champion_levels + lay.levels;
+    for (long long b; (b = claimBatch(lay, gen)) >= 0;) {
+        fill(delta.begin(), delta.end(), 0);
+        for (long long i = b * lay.batch_games, end = i + lay.gamesIn(b); i < end; ++i) {
+            g.reset(MonteCarloRunner::gameSeed(seed, i));
+            g.setGameId(i);
+            g.generatePlayers(lay.players);
+            g.gameLoop();
+
+            BasicRPG<Rules> champ = g.getPlayer(g.getChampion());
+            delta[0] += 1;
+            wins[champ.getId()] += 1;
+            champion_levels[min(champ.getLevel(), lay.levels - 1)] += 1;
+            for (int p = 0; p < g.getNumPlayers(); ++p)
+                player_levels[min(g.getPlayer(p).getLevel(), lay.levels - 1)] += 1;
+        }
+        addCells(lay.copy(w, 1 - cur), delta);
+        cur = 1 - cur;
+        lay.commit(w).store((uint64_t)(b + 1) << 1 | cur, memory_order_release);
+        lay.state(b).store(BATCH_DONE | gen, memory_order_release);
+        addCells(lay.copy(w, 1 - cur), delta);
+    }
+}
+
+SimulationFarm::SimulationFarm(int n, unsigned s, int w, const string& r, long long b)
+    : players_per_game(n), seed(s), workers(w <= 0 ? defaultThreads() : w), rules(r),
+      batch_games(b < 1 ? 1 : b), restarted(0), lost(0) {}
+
+MonteCarloResult SimulationFarm::run(long long games) {
+    MonteCarloResult total;
+    withRules(rules, [&](auto r) { total = runWith<decltype(r)>(games); });
+    return total;
+}
+
+static void trimZeros(vector<long long>& hist) {
+    while (!hist.empty() && hist.back() == 0) hist.pop_back();
+}
+
+template <class Rules>
+MonteCarloResult SimulationFarm::runWith(long long games) {
+    restarted = 0;
+    lost = 0;
+    MonteCarloResult total;
+    if (games <= 0 || players_per_game <= 0) return total;
+    FarmLayout lay(players_per_game, games, batch_games, workers);
+    lay.base = mapSegment(lay.bytes);
+    if (!lay.base) return total;
+    new (&lay.next()) atomic<long long>(0);
+    for (long long b = 0; b < lay.batches; ++b) new (&lay.state(b)) atomic<uint32_t>(BATCH_FREE);
+    for (int w = 0; w < workers; ++w) new (&lay.commit(w)) atomic<uint64_t>(0);
+
+    vector<pid_t>    pids(workers, -1);
+    vector<uint32_t> gens(workers, 0);
+    uint32_t next_gen = 1;
+    int live = 0;
+    auto spawn = [&](int w) {
+        gens[w] = next_gen++;
+        fflush(stdout);             // or the child's copy of the buffer is written twice
+        pid_t pid = fork();
+        if (pid == 0) {
+            farmWorker<Rules>(lay, w, gens[w], seed);
+            _exit(0);
+        }
+        pids[w] = pid;
+        if (pid > 0) ++live;
+        return pid > 0;
+    };
+    for (int w = 0; w < workers; ++w) spawn(w);
+
+    // The coordinator only sleeps in waitpid; it wakes when a worker ends.
+    vector<int> attempts(lay.batches, 0);
+    int spare_restarts = MAX_ATTEMPTS * workers;    // for deaths that held no batch
+    while (live > 0) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        int w = (int)(find(pids.begin(), pids.end(), pid) - pids.begin());
+        if (w == workers) continue;
+        pids[w] = -1;
+        --live;
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) continue;
+
+        // hand back what it held, unless its commit word already counts it
+        long long committed = (long long)(lay.commit(w).load(memory_order_acquire) >> 1) - 1;
+        bool held = false;
+        for (long long b = 0; b < lay.batches; ++b) {
+            if (lay.state(b).load(memory_order_acquire) != gens[w]) continue;
+            held = true;
+            if (b == committed) lay.state(b).store(BATCH_DONE | gens[w]);
+            else if (++attempts[b] >= MAX_ATTEMPTS) lay.state(b).store(BATCH_ABANDONED);
+            else lay.state(b).store(BATCH_FREE);
+        }
+        bool work_left = lay.next().load() < lay.batches;
+        for (long long b = 0; !work_left && b < lay.batches; ++b) work_left = lay.state(b).load() == BATCH_FREE;
+        if (work_left && (held || spare_restarts-- > 0) && spawn(w)) ++restarted;
+    }
+
+    total.wins_by_player.assign(players_per_game, 0);
+    total.champion_levels.assign(lay.levels, 0);
+    total.player_levels.assign(lay.levels, 0);
+    for (int w = 0; w < workers; ++w) {
+        const long long* c = lay.copy(w, (int)(lay.commit(w).load() & 1));
+        total.games += c[0];
+        for (int i = 0; i < players_per_game; ++i) total.wins_by_player[i] += c[1 + i];
+        for (int lv = 0; lv < lay.levels; ++lv) {
+            total.champion_levels[lv] += c[1 + players_per_game + lv];
+            total.player_levels[lv] += c[1 + players_per_game + lay.levels + lv];
+        }
+    }
+    trimZeros(total.champion_levels);
+    trimZeros(total.player_levels);
+    for (long long b = 0; b < lay.batches; ++b) {
+        uint32_t s = lay.state(b).load();
+        if (s == BATCH_ABANDONED || !(s & BATCH_DONE)) lost += lay.gamesIn(b);
+    }
+    munmap(lay.base, lay.bytes);
+    return total;
+}
@@ -0,0 +1,51 @@
+#ifndef SIMULATIONFARM_H
+#define SIMULATIONFARM_H
+
+#include <string>
+#include "MonteCarloRunner.h"
+using namespace std;
+
+// MonteCarloRunner's games played by forked worker processes instead of
+// threads, so a crashing game takes down one worker, not the run. Game i
+// gets the same seed and game id as under MonteCarloRunner, so both give
+// the same histograms.
+//
+// Everything the processes share lives in one POSIX shared-memory segment,
+// unlinked as soon as it is mapped, so nothing is left behind:
+//   queue    a cursor over batches of games and one state word per batch
+//            (free, claimed by worker generation g, done); workers claim
+//            a batch with a compare-exchange on its word
+//   slots    per worker, two copies of its histograms and a commit word
+//            naming the copy that is whole and the last batch in it
+// A worker folds each finished batch into the spare copy, flips the commit
+// word, then brings the other copy level. No pipes, files or locks.
+//
+// When a worker dies the coordinator hands its claimed batch back to the
+// queue, unless the commit word shows it already counted, and starts a
+// fresh worker on the same slot. A batch that takes down a worker
+// MAX_ATTEMPTS times is abandoned and its games left out (see lostGames()).
+class SimulationFarm {
+public:
+    SimulationFarm(int players_per_game, unsigned seed, int workers = 0,
+                   const string& rules = "classic", long long batch_games = 256);
+
+    MonteCarloResult run(long long games); // games == 0 if the segment cannot be made
+
+    int       restarts() const { return restarted; }   // workers replaced in the last run
+    long long lostGames() const { return lost; }       // games in abandoned batches
+
+    static const int MAX_ATTEMPTS = 3;
+
+private:
+    template <class Rules> MonteCarloResult runWith(long long games);
+
+    int       players_per_game;
+    unsigned  seed;
+    int       workers;                  // 0 = hardware_concurrency
+    string    rules;
+    long long batch_games;
+    int       restarted;
+    long long lost;
+};
+
+#endif
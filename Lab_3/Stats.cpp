@@ -0,0 +1,87 @@
+#include "Stats.h"
+
+#ifdef LAB3_STATS
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+static const char* COUNTER_NAMES[STAT_COUNTER_COUNT] = {
+    "attacks", "hits", "misses", "duels", "level_ups", "select_retries"
+};
+static const char* PHASE_NAMES[STAT_PHASE_COUNT] = {
+    "selection", "combat", "reporting"
+};
+
+// Blocks outlive their threads so a report after join still sees them.
+static mutex                            registry_lock;
+static vector<unique_ptr<ThreadStats> > registry;
+
+static ThreadStats* registerThread() {
+    unique_ptr<ThreadStats> block(new ThreadStats());
+    ThreadStats* raw = block.get();
+    lock_guard<mutex> guard(registry_lock);
+    registry.push_back(move(block));
+    return raw;
+}
+
+ThreadStats& threadStats() {
+    thread_local ThreadStats* mine = registerThread();
+    return *mine;
+}
+
+static ThreadStats totals(size_t& threads) {
+    ThreadStats sum = ThreadStats();
+    lock_guard<mutex> guard(registry_lock);
+    threads = registry.size();
+    for (const unique_ptr<ThreadStats>& t : registry) {
+        for (int c = 0; c < STAT_COUNTER_COUNT; ++c) sum.counters[c] += t->counters[c];
+        for (int p = 0; p < STAT_PHASE_COUNT; ++p) sum.phase_ns[p] += t->phase_ns[p];
+    }
+    return sum;
+}
+
+void statsReset() {
+    lock_guard<mutex> guard(registry_lock);
+    for (unique_ptr<ThreadStats>& t : registry) *t = ThreadStats();
+}
+
+void statsReport(const string& path) {
+    size_t threads = 0;
+    ThreadStats sum = totals(threads);
+
+    if (path.empty()) {
+        cerr << "---- lab3 stats (" << threads << " threads) ----\n";
+        for (int c = 0; c < STAT_COUNTER_COUNT; ++c)
+            cerr << COUNTER_NAMES[c] << ": " << sum.counters[c] << '\n';
+        for (int p = 0; p < STAT_PHASE_COUNT; ++p)
+            cerr << PHASE_NAMES[p] << " time: " << sum.phase_ns[p] / 1e9 << " s\n";
+        return;
+    }
+
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        cerr << "stats: cannot write " << path << '\n';
+        return;
+    }
+    for (int c = 0; c < STAT_COUNTER_COUNT; ++c) {
+        fprintf(f, "# TYPE lab3_%s_total counter\n", COUNTER_NAMES[c]);
+        fprintf(f, "lab3_%s_total %lld\n", COUNTER_NAMES[c], sum.counters[c]);
+    }
+    fprintf(f, "# TYPE lab3_phase_seconds_total counter\n");
+    for (int p = 0; p < STAT_PHASE_COUNT; ++p)
+        fprintf(f, "lab3_phase_seconds_total{phase=\"%s\"} %.9f\n", PHASE_NAMES[p], sum.phase_ns[p] / 1e9);
+    fprintf(f, "# TYPE lab3_stat_threads gauge\nlab3_stat_threads %zu\n", threads);
+    fclose(f);
+}
+
+void statsDump() {
+    const char* path = getenv("LAB3_STATS_FILE");
+    statsReport(path ? path : "");
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef STATS_H
+#define STATS_H
+
+// Optional hot-path instrumentation. Build with -DLAB3_STATS to enable;
+// without it every LAB3_COUNT / LAB3_PHASE expands to nothing.
+
+#include <string>
+using namespace std;
+
+enum StatCounter {
+    STAT_ATTACKS,
+    STAT_HITS,
+    STAT_MISSES,
+    STAT_DUELS,
+    STAT_LEVEL_UPS,
+    STAT_SELECT_RETRIES,            // extra picks in battleRound's idx2 == idx1 loop
+    STAT_COUNTER_COUNT
+};
+
+enum StatPhase {
+    PHASE_SELECTION,
+    PHASE_COMBAT,
+    PHASE_REPORTING,
+    STAT_PHASE_COUNT
+};
+
+#ifdef LAB3_STATS
+
+#include <chrono>
+
+// One block per thread, on its own cache line; only its owner writes it.
+struct alignas(64) ThreadStats {
+    long long counters[STAT_COUNTER_COUNT];
+    long long phase_ns[STAT_PHASE_COUNT];
+};
+
+ThreadStats& threadStats();         // calling thread's block, registered on first use
+
+// Totals across all threads. Call when the workers are idle (after a join).
+void statsReset();
+void statsReport(const string& path); // Prometheus text to path, or a summary on stderr if empty
+void statsDump();                   // statsReport($LAB3_STATS_FILE)
+
+// Adds the lifetime of the scope to one phase.
+class PhaseTimer {
+public:
+    explicit PhaseTimer(StatPhase p) : phase(p), start(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer() {
+        threadStats().phase_ns[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    StatPhase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define LAB3_COUNT(counter, n) (threadStats().counters[counter] += (n))
+#define LAB3_PHASE(phase)      PhaseTimer lab3_phase_timer_(phase)
+#define LAB3_STATS_DUMP()      statsDump()
+
+#else
+
+#define LAB3_COUNT(counter, n) ((void)0)
+#define LAB3_PHASE(phase)      ((void)0)
+#define LAB3_STATS_DUMP()      ((void)0)
+
+#endif
+
+#endif
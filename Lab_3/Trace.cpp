@@ -0,0 +1,206 @@
+#include "Trace.h"
+#include <algorithm>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+static const char   TRACE_MAGIC[4]  = { 'L', '3', 'T', 'R' };
+static const size_t HEADER_BYTES    = 4 + 4 + 8 + 8;
+static const size_t FOOTER_BYTES    = 8 + 8 + 4;
+static const size_t INDEX_BYTES     = 8 + 8 + 4 + 4 + 4 + 4;
+static const size_t SPILL_BYTES     = 1 << 20;
+
+// little-endian fixed-width fields
+static void put32(vector<uint8_t>& b, uint32_t v) {
+    for (int i = 0; i < 4; ++i) b.push_back((uint8_t)(v >> (8 * i)));
+}
+static void put64(vector<uint8_t>& b, uint64_t v) {
+    for (int i = 0; i < 8; ++i) b.push_back((uint8_t)(v >> (8 * i)));
+}
+static uint32_t get32(const uint8_t* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+static uint64_t get64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+
+// ---- writer ----------------------------------------------------------------
+
+TraceWriter::TraceWriter(const string& path, uint64_t seed, uint64_t game_id)
+    : out(fopen(path.c_str(), "wb")), written(0), last_round(0), last_a(0), last_b(0) {
+    buf.reserve(SPILL_BYTES + 64);
+    buf.insert(buf.end(), TRACE_MAGIC, TRACE_MAGIC + 4);
+    put32(buf, TRACE_VERSION);
+    put64(buf, seed);
+    put64(buf, game_id);
+}
+
+TraceWriter::~TraceWriter() { close(); }
+
+void TraceWriter::putVarint(uint64_t v) {
+    while (v >= 0x80) {
+        buf.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    buf.push_back((uint8_t)v);
+}
+
+void TraceWriter::begin(uint8_t tag, long long round, int a, int b) {
+    if (index.empty() || index.back().events == (uint32_t)TRACE_BLOCK_EVENTS) {
+        TraceBlock blk = { written + buf.size(), (uint64_t)round, 0, 0, INT_MAX, INT_MIN };
+        index.push_back(blk);
+        last_round = 0;                 // every block decodes on its own
+        last_a = 0;
+        last_b = 0;
+    }
+    bool new_block = index.back().events == 0;
+    if (!new_block && round == last_round) tag |= TRACE_SAME_ROUND;
+    if (!new_block && a == last_a && b == last_b) tag |= TRACE_SAME_PAIR;
+    else if (!new_block && a == last_b && b == last_a) tag |= TRACE_SWAPPED;
+    TraceBlock& blk = index.back();
+    blk.min_player = min(blk.min_player, min(a, b));
+    blk.max_player = max(blk.max_player, max(a, b));
+    buf.push_back(tag);
+    if (!(tag & TRACE_SAME_ROUND)) putVarint((uint64_t)(round - last_round));
+    if (!(tag & (TRACE_SAME_PAIR | TRACE_SWAPPED))) {
+        putVarint(zigzag((int64_t)a - last_a));
+        putVarint(zigzag((int64_t)b - last_b));
+    }
+    last_round = round;
+    last_a = a;
+    last_b = b;
+}
+
+void TraceWriter::endEvent() {
+    TraceBlock& blk = index.back();
+    blk.events += 1;
+    blk.bytes = (uint32_t)(written + buf.size() - blk.offset);
+    if (buf.size() >= SPILL_BYTES) spill();
+}
+
+void TraceWriter::spill() {
+    if (out && !buf.empty()) fwrite(buf.data(), 1, buf.size(), out);
+    written += buf.size();
+    buf.clear();
+}
+
+void TraceWriter::swing(long long round, int attacker, int defender, bool hit) {
+    if (!out) return;
+    begin((uint8_t)(TRACE_SWING | (hit ? TRACE_HIT : 0)), round, attacker, defender);
+    endEvent();
+}
+
+void TraceWriter::result(long long round, int winner, int loser, float exp, int level_delta) {
+    if (!out) return;
+    begin(TRACE_RESULT, round, winner, loser);
+    uint32_t bits;
+    memcpy(&bits, &exp, 4);
+    put32(buf, bits);
+    putVarint(zigzag(level_delta));
+    endEvent();
+}
+
+void TraceWriter::close() {
+    if (!out) return;
+    uint64_t index_offset = written + buf.size();
+    for (const TraceBlock& blk : index) {
+        put64(buf, blk.offset);
+        put64(buf, blk.first_round);
+        put32(buf, blk.events);
+        put32(buf, blk.bytes);
+        put32(buf, (uint32_t)blk.min_player);
+        put32(buf, (uint32_t)blk.max_player);
+    }
+    put64(buf, index_offset);
+    put64(buf, index.size());
+    buf.insert(buf.end(), TRACE_MAGIC, TRACE_MAGIC + 4);
+    spill();
+    fclose(out);
+    out = nullptr;
+}
+
+// ---- reader ----------------------------------------------------------------
+
+TraceReader::TraceReader(const string& path) : data(nullptr), size(0), damaged(false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_BYTES + FOOTER_BYTES) {
+        ::close(fd);
+        return;
+    }
+    void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) return;
+    const uint8_t* p = (const uint8_t*)m;
+    size_t n = st.st_size;
+
+    const uint8_t* foot = p + n - FOOTER_BYTES;
+    uint64_t index_offset = get64(foot);
+    uint64_t count = get64(foot + 8);
+    bool valid = memcmp(p, TRACE_MAGIC, 4) == 0 && get32(p + 4) == TRACE_VERSION
+              && memcmp(foot + 16, TRACE_MAGIC, 4) == 0
+              && index_offset >= HEADER_BYTES && index_offset <= n - FOOTER_BYTES
+              && count == (n - FOOTER_BYTES - index_offset) / INDEX_BYTES
+              && index_offset + count * INDEX_BYTES + FOOTER_BYTES == n;
+    // every block inside the data, after the one before it, rounds not going back
+    uint64_t data_end = HEADER_BYTES, last_round = 0;
+    if (valid) blocks.resize(count);
+    for (uint64_t i = 0; valid && i < count; ++i) {
+        const uint8_t* e = p + index_offset + INDEX_BYTES * i;
+        TraceBlock& blk = blocks[i];
+        blk.offset = get64(e);
+        blk.first_round = get64(e + 8);
+        blk.events = get32(e + 16);
+        blk.bytes = get32(e + 20);
+        blk.min_player = (int32_t)get32(e + 24);
+        blk.max_player = (int32_t)get32(e + 28);
+        valid = blk.offset >= data_end && blk.offset <= index_offset
+             && blk.bytes <= index_offset - blk.offset && blk.events <= blk.bytes
+             && blk.first_round >= last_round
+             && (blk.events == 0 || blk.min_player <= blk.max_player);
+        data_end = blk.offset + blk.bytes;
+        last_round = blk.first_round;
+    }
+    if (!valid) {
+        blocks.clear();
+        munmap(m, n);
+        return;
+    }
+    madvise(m, n, MADV_SEQUENTIAL);
+    data = p;
+    size = n;
+}
+
+TraceReader::~TraceReader() {
+    if (data) munmap((void*)data, size);
+}
+
+long long TraceReader::eventCount() const {
+    long long total = 0;
+    for (const TraceBlock& b : blocks) total += b.events;
+    return total;
+}
+
+uint64_t TraceReader::seed() const { return data ? get64(data + 8) : 0; }
+uint64_t TraceReader::gameId() const { return data ? get64(data + 16) : 0; }
+
+// last block that starts at or before round (a round may span two blocks)
+int TraceReader::firstBlockFor(long long round) const {
+    int lo = 0, hi = (int)blocks.size();
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if ((long long)blocks[mid].first_round < round) lo = mid + 1;
+        else hi = mid;
+    }
+    return max(0, lo - 1);
+}
@@ -0,0 +1,218 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Binary battle trace.
+//
+// File layout:
+//   header   "L3TR", u32 version, u64 seed, u64 game id
+//   blocks   up to TRACE_BLOCK_EVENTS records each; delta state resets per block
+//   index    one TraceBlock per block, in file order
+//   footer   u64 index offset, u64 block count, "L3TR"
+//
+// Record: one tag byte, then only the fields the tag does not imply:
+//   varint round delta           unless TRACE_SAME_ROUND
+//   zigzag attacker, defender    deltas, unless TRACE_SAME_PAIR / TRACE_SWAPPED
+//   Result records add the winner's exp after the round (4 raw bytes)
+//   and a zigzag level delta.
+// Inside a duel the fighters just alternate, so most swings are one byte.
+//
+// The reader checks the index when it opens a file (every block inside the
+// data, in order, none overlapping) and never decodes past a block's bytes,
+// so a damaged file loses blocks, not the process.
+
+const uint32_t TRACE_VERSION      = 3;    // 2: player range per block, 3: 64-bit seed
+const int      TRACE_BLOCK_EVENTS = 4096;
+
+enum TraceKind : uint8_t {
+    TRACE_SWING  = 0,               // attacker swung at defender
+    TRACE_RESULT = 1                // attacker beat defender, round over
+};
+
+// tag bits
+const uint8_t TRACE_KIND_BIT   = 1;
+const uint8_t TRACE_HIT        = 2;
+const uint8_t TRACE_SAME_ROUND = 4;
+const uint8_t TRACE_SAME_PAIR  = 8;  // same attacker and defender as the previous record
+const uint8_t TRACE_SWAPPED    = 16; // attacker and defender of the previous record, swapped
+
+struct TraceEvent {
+    uint8_t   kind;
+    bool      hit;                  // swings only
+    long long round;
+    int       attacker;             // winner for results
+    int       defender;             // loser for results
+    float     exp;                  // results only: winner's exp afterwards
+    int       level_delta;          // results only
+};
+
+struct TraceBlock {
+    uint64_t offset;                // file offset of the first record
+    uint64_t first_round;
+    uint32_t events;
+    uint32_t bytes;
+    int32_t  min_player;            // lowest attacker or defender in the block
+    int32_t  max_player;            // highest; forPlayer skips blocks outside the range
+};
+
+class TraceWriter {
+public:
+    TraceWriter(const string& path, uint64_t seed, uint64_t game_id);
+    ~TraceWriter();                 // close() if still open
+
+    bool ok() const { return out != nullptr; }
+    void swing(long long round, int attacker, int defender, bool hit);
+    void result(long long round, int winner, int loser, float exp, int level_delta);
+    void close();                   // write the index and footer
+
+private:
+    void begin(uint8_t tag, long long round, int a, int b);
+    void putVarint(uint64_t v);
+    void endEvent();
+    void spill();                   // write the buffer out
+
+    FILE*              out;
+    vector<uint8_t>    buf;
+    uint64_t           written;     // bytes already in the file
+    vector<TraceBlock> index;
+    long long          last_round;
+    int                last_a, last_b;
+};
+
+// Memory-maps a trace for random access by round and filtering by player.
+class TraceReader {
+public:
+    explicit TraceReader(const string& path);
+    ~TraceReader();
+
+    bool      ok() const { return data != nullptr; }
+    bool      intact() const { return !damaged; } // false once a block ran past its bytes
+    long long eventCount() const;
+    int       blockCount() const { return (int)blocks.size(); }
+    uint64_t  seed() const;
+    uint64_t  gameId() const;
+
+    // Calls f(event) for every event in [first_round, last_round], in order.
+    template <class F> void forRounds(long long first_round, long long last_round, F f) const;
+    // Calls f(event) for every event where player is attacker or defender.
+    template <class F> void forPlayer(int player, F f) const;
+    template <class F> void forEach(F f) const { forRounds(0, INT64_MAX, f); }
+
+private:
+    int  firstBlockFor(long long round) const;
+    template <class F> bool forBlock(const TraceBlock& blk, F f) const;
+    const uint8_t* decode(const uint8_t* p, const uint8_t* end, TraceEvent& e, TraceEvent& prev) const;
+
+    const uint8_t*     data;
+    size_t             size;
+    vector<TraceBlock> blocks;
+    mutable bool       damaged;
+};
+
+// ---- inline decoding -----------------------------------------------------
+
+// nullptr if the varint runs past end or past 64 bits
+inline const uint8_t* traceVarint(const uint8_t* p, const uint8_t* end, uint64_t& v) {
+    uint64_t x = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = *p++;
+        x |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            v = x;
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+inline int64_t traceUnzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+// One record from [p, end); nullptr if it does not fit.
+inline const uint8_t* TraceReader::decode(const uint8_t* p, const uint8_t* end, TraceEvent& e,
+                                          TraceEvent& prev) const {
+    if (p >= end) return nullptr;
+    uint8_t tag = *p++;
+    uint64_t v;
+    e.kind = tag & TRACE_KIND_BIT;
+    e.hit = (tag & TRACE_HIT) != 0;
+    e.round = prev.round;
+    if (!(tag & TRACE_SAME_ROUND)) {
+        if (!(p = traceVarint(p, end, v))) return nullptr;
+        e.round += (long long)v;
+    }
+    if (tag & TRACE_SAME_PAIR) {
+        e.attacker = prev.attacker;
+        e.defender = prev.defender;
+    } else if (tag & TRACE_SWAPPED) {
+        e.attacker = prev.defender;
+        e.defender = prev.attacker;
+    } else {
+        if (!(p = traceVarint(p, end, v))) return nullptr;
+        e.attacker = prev.attacker + (int)traceUnzigzag(v);
+        if (!(p = traceVarint(p, end, v))) return nullptr;
+        e.defender = prev.defender + (int)traceUnzigzag(v);
+    }
+    if (e.kind == TRACE_RESULT) {
+        if (end - p < 4) return nullptr;
+        uint32_t bits = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+        memcpy(&e.exp, &bits, 4);
+        p += 4;
+        if (!(p = traceVarint(p, end, v))) return nullptr;
+        e.level_delta = (int)traceUnzigzag(v);
+    } else {
+        e.exp = 0.0f;
+        e.level_delta = 0;
+    }
+    prev = e;
+    return p;
+}
+
+// Calls f(event) for each record of blk until f returns false (then false).
+// A record that would run past the block ends it and marks the trace damaged.
+template <class F>
+bool TraceReader::forBlock(const TraceBlock& blk, F f) const {
+    const uint8_t* p = data + blk.offset;
+    const uint8_t* end = p + blk.bytes;
+    TraceEvent prev = TraceEvent();
+    TraceEvent e;
+    for (uint32_t i = 0; i < blk.events; ++i) {
+        if (!(p = decode(p, end, e, prev))) {
+            damaged = true;
+            return true;
+        }
+        if (!f(e)) return false;
+    }
+    return true;
+}
+
+template <class F>
+void TraceReader::forRounds(long long first_round, long long last_round, F f) const {
+    for (int b = firstBlockFor(first_round); b < (int)blocks.size(); ++b) {
+        if ((long long)blocks[b].first_round > last_round) return;
+        bool more = forBlock(blocks[b], [&](const TraceEvent& e) {
+            if (e.round > last_round) return false;
+            if (e.round >= first_round) f(e);
+            return true;
+        });
+        if (!more) return;
+    }
+}
+
+template <class F>
+void TraceReader::forPlayer(int player, F f) const {
+    for (const TraceBlock& blk : blocks) {
+        if (player < blk.min_player || player > blk.max_player) continue;
+        forBlock(blk, [&](const TraceEvent& e) {
+            if (e.attacker == player || e.defender == player) f(e);
+            return true;
+        });
+    }
+}
+
+#endif
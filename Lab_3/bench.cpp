@@ -0,0 +1,310 @@
+// Benchmark for the Lab_3 tournament engine (Linux).
+//
+// Build from Lab_3:
+//   g++ -std=c++17 -O2 -pthread bench.cpp $(ls *.cpp | grep -v -e main.cpp -e bench.cpp -e _test.cpp) -o bench
+//
+// Run:
+//   ./bench [max_n] > new.json        one JSON object per size, n = 10 .. max_n
+//   ./bench --compare old.json new.json
+//   ./bench --kernels                 ns per duel of each resolveDuelBatch kernel
+//
+// Each size runs in a forked child so peak RSS and allocation counts belong
+// to that size alone. So does each duel kernel, picked there through
+// LAB3_DUEL_KERNEL before its first duel.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "DuelKernel.h"
+#include "Game.h"
+using namespace std;
+
+// ---- allocation counting -------------------------------------------------
+
+static atomic<long long> g_allocs(0);
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// the PlayerPool arena is cache-line aligned
+void* operator new[](size_t size, align_val_t align) {
+    g_allocs.fetch_add(1, memory_order_relaxed);
+    size_t a = (size_t)align;
+    if (void* p = aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw bad_alloc();
+}
+void operator delete[](void* p, align_val_t) noexcept { free(p); }
+void operator delete[](void* p, size_t, align_val_t) noexcept { free(p); }
+
+// ---- measurement helpers -------------------------------------------------
+
+typedef chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start) {
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+static long peakRssKb() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;                // kilobytes on Linux
+}
+
+struct Timing {
+    double    seconds;
+    long long ops;
+    long long allocs;
+};
+
+template <class Body>
+static Timing measure(long long ops, Body body) {
+    long long a0 = g_allocs.load();
+    Clock::time_point t0 = Clock::now();
+    body();
+    double s = secondsSince(t0);
+    return { s, ops, g_allocs.load() - a0 };
+}
+
+static void printTiming(const char* name, const Timing& t, bool last) {
+    double ns = t.ops > 0 ? 1e9 * t.seconds / t.ops : 0.0;
+    double per_sec = t.seconds > 0 ? t.ops / t.seconds : 0.0;
+    printf("\"%s\": {\"ns_per_op\": %.2f, \"ops_per_sec\": %.1f, \"ops\": %lld, \"allocs\": %lld}%s",
+           name, ns, per_sec, t.ops, t.allocs, last ? "" : ", ");
+}
+
+// ---- one size -------------------------------------------------------------
+
+static const unsigned SEED = 12345;
+
+static void runSize(int n) {
+    // generatePlayers
+    Timing gen;
+    {
+        Game g(SEED);
+        g.setEventSink(silentSink());
+        gen = measure(n, [&] { g.generatePlayers(n); });
+    }
+
+    // selectPlayer on a full field
+    Timing sel;
+    {
+        Game g(SEED);
+        g.setEventSink(silentSink());
+        g.generatePlayers(n);
+        long long picks = max(n, 1000000);
+        volatile int sink = 0;
+        sel = measure(picks, [&] {
+            for (long long i = 0; i < picks; ++i) sink = g.selectPlayer();
+        });
+        (void)sink;
+    }
+
+    // battleRound, from a full field down (capped so the big sizes stay short)
+    Timing battle;
+    {
+        Game g(SEED);
+        g.setEventSink(silentSink());
+        g.generatePlayers(n);
+        long long rounds = min(n - 1, 1000000);
+        battle = measure(rounds, [&] {
+            for (long long i = 0; i < rounds; ++i) g.battleRound();
+        });
+    }
+
+    // full gameLoop
+    Timing loop;
+    {
+        Game g(SEED);
+        g.setEventSink(silentSink());
+        g.generatePlayers(n);
+        loop = measure(n - 1, [&] { g.gameLoop(); });
+    }
+
+    printf("{\"n\": %d, ", n);
+    printTiming("generatePlayers", gen, false);
+    printTiming("selectPlayer", sel, false);
+    printTiming("battleRound", battle, false);
+    printTiming("gameLoop", loop, false);
+    printf("\"gameLoop_seconds\": %.6f, \"peak_rss_kb\": %ld}\n", loop.seconds, peakRssKb());
+    fflush(stdout);
+}
+
+// ---- --compare -----------------------------------------------------------
+
+// Pulls every "<section>.<metric>" number out of one line of our own output.
+static map<string, double> parseLine(const string& line) {
+    map<string, double> out;
+    string section;
+    size_t i = 0;
+    while ((i = line.find('"', i)) != string::npos) {
+        size_t j = line.find('"', i + 1);
+        if (j == string::npos) break;
+        string key = line.substr(i + 1, j - i - 1);
+        size_t k = line.find_first_not_of(": ", j + 1);
+        i = j + 1;
+        if (k == string::npos) break;
+        if (line[k] == '{') {
+            section = key + ".";
+        } else {
+            out[section + key] = atof(line.c_str() + k);
+            size_t close = line.find_first_of(",}", k);
+            if (close != string::npos && line[close] == '}') section.clear();
+        }
+    }
+    return out;
+}
+
+static map<int, map<string, double> > loadRuns(const char* path) {
+    map<int, map<string, double> > runs;
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        map<string, double> m = parseLine(line);
+        if (m.count("n")) runs[(int)m["n"]] = m;
+    }
+    return runs;
+}
+
+static int compare(const char* old_path, const char* new_path) {
+    map<int, map<string, double> > a = loadRuns(old_path);
+    map<int, map<string, double> > b = loadRuns(new_path);
+    const char* metrics[] = { "generatePlayers.ns_per_op", "selectPlayer.ns_per_op",
+                              "battleRound.ns_per_op", "gameLoop.ns_per_op",
+                              "gameLoop.allocs", "peak_rss_kb" };
+    printf("%-10s %-28s %14s %14s %9s\n", "n", "metric", "old", "new", "change");
+    for (auto& run : b) {
+        if (!a.count(run.first)) continue;
+        for (const char* m : metrics) {
+            double x = a[run.first][m], y = run.second[m];
+            double pct = x != 0 ? 100.0 * (y - x) / x : 0.0;
+            printf("%-10d %-28s %14.2f %14.2f %+8.1f%%\n", run.first, m, x, y, pct);
+        }
+    }
+    return 0;
+}
+
+// ---- --kernels -----------------------------------------------------------
+
+static const int KERNEL_DUELS = 1 << 16;   // the pools stay in cache
+static const int KERNEL_REPS  = 50;
+
+// Best time per duel over KERNEL_REPS rounds of KERNEL_DUELS disjoint pairs,
+// every fighter fresh, luck 0.1 - 3.0 (levels 1 - 30).
+template <class Rules>
+static double kernelNsPerDuel() {
+    PlayerPool pool;
+    pool.reserve(2 * KERNEL_DUELS);
+    vector<int> p1(KERNEL_DUELS), p2(KERNEL_DUELS);
+    for (int i = 0; i < 2 * KERNEL_DUELS; ++i) pool.luckOf(pool.add()) = 0.1f * (1 + i % 30);
+    for (int i = 0; i < KERNEL_DUELS; ++i) {
+        p1[i] = 2 * i;
+        p2[i] = 2 * i + 1;
+    }
+    vector<DuelResult> out(KERNEL_DUELS);
+    double best = 1e30;
+    for (int rep = 0; rep < KERNEL_REPS; ++rep) {
+        for (int i = 0; i < pool.size(); ++i) pool.hitsTaken(i) = 0;
+        Clock::time_point t0 = Clock::now();
+        resolveDuelBatch<Rules>(pool, p1.data(), p2.data(), KERNEL_DUELS, SEED, 0, rep, out.data());
+        best = min(best, secondsSince(t0));
+    }
+    return 1e9 * best / KERNEL_DUELS;
+}
+
+// In a child: one JSON line for the kernel `want`, or nothing if this CPU
+// does not have it. LAB3_DUEL_KERNEL only narrows, so avx512 is the default.
+static void runKernel(const char* want) {
+    if (strcmp(want, "avx512") == 0) unsetenv("LAB3_DUEL_KERNEL");
+    else setenv("LAB3_DUEL_KERNEL", want, 1);
+    if (strcmp(duelKernelName(), want) != 0) return;
+    printf("{\"kernel\": \"%s\", \"classic\": {\"ns_per_duel\": %.2f}, "
+           "\"sudden-death\": {\"ns_per_duel\": %.2f}, \"endurance\": {\"ns_per_duel\": %.2f}}\n",
+           want, kernelNsPerDuel<ClassicRules>(), kernelNsPerDuel<SuddenDeathRules>(),
+           kernelNsPerDuel<EnduranceRules>());
+}
+
+// Runs each kernel in a child, echoes its line and then the speedups over scalar.
+static int kernels() {
+    const char* names[] = { "scalar", "avx2", "avx512" };
+    const char* rules[] = { "classic", "sudden-death", "endurance" };
+    map<string, double> scalar;
+    for (const char* k : names) {
+        int fds[2];
+        if (pipe(fds) != 0) return 1;
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[0]);
+            runKernel(k);
+            fflush(stdout);
+            _exit(0);
+        }
+        close(fds[1]);
+        string line;
+        char buf[512];
+        for (ssize_t got; (got = read(fds[0], buf, sizeof buf)) > 0;) line.append(buf, got);
+        close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            cerr << "bench: kernel " << k << " failed\n";
+            return 1;
+        }
+        if (line.empty()) continue;     // not on this CPU
+        fputs(line.c_str(), stdout);
+        map<string, double> m = parseLine(line);
+        if (scalar.empty()) scalar = m;
+        if (m == scalar) continue;
+        printf("{\"kernel\": \"%s\", \"speedup_vs_scalar\": {", k);
+        for (int r = 0; r < 3; ++r) {
+            string key = string(rules[r]) + ".ns_per_duel";
+            printf("\"%s\": %.2f%s", rules[r], scalar[key] / m[key], r < 2 ? ", " : "}}\n");
+        }
+    }
+    return 0;
+}
+
+// ---- main ----------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    if (argc > 3 && strcmp(argv[1], "--compare") == 0) {
+        return compare(argv[2], argv[3]);
+    }
+    if (argc > 1 && strcmp(argv[1], "--kernels") == 0) return kernels();
+
+    long long max_n = (argc > 1) ? atoll(argv[1]) : 10000000;
+    int sizes[] = { 10, 1000, 100000, 10000000 };
+
+    for (int n : sizes) {
+        if (n > max_n) break;
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            runSize(n);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            cerr << "bench: size " << n << " failed\n";
+            return 1;
+        }
+    }
+    return 0;
+}
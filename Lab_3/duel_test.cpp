@@ -0,0 +1,120 @@
+// Statistical check that resolveDuel samples the same duels as simulateDuel.
+//
+// Build from Lab_3:
+//   g++ -std=c++17 -O2 -pthread duel_test.cpp $(ls *.cpp | grep -v -e main.cpp -e bench.cpp -e _test.cpp) -o duel_test
+//
+// Run:
+//   ./duel_test [duels]            exit status 0 if every case agrees
+//
+// For each rule set and a spread of luck / hits_taken starting points, both
+// functions fight the same pair `duels` times from fresh state. P1's win
+// rate, the mean swings and the winner's hits taken afterwards must agree
+// within MAX_Z standard errors of the difference.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "Duel.h"
+#include "PlayerPool.h"
+using namespace std;
+
+static const double MAX_Z = 4.5;   // ~1 false alarm per 150k comparisons
+
+struct Moments {
+    long long n = 0;
+    double    sum = 0, sum_sq = 0;
+
+    void   add(double x) { ++n; sum += x; sum_sq += x * x; }
+    double mean() const { return sum / n; }
+    double var() const { return n > 1 ? (sum_sq - sum * sum / n) / (n - 1) : 0.0; }
+};
+
+struct Tally {
+    Moments p1_wins, swings, winner_hits;
+};
+
+struct Case {
+    float luck1, luck2;
+    int   hits1, hits2;
+};
+
+// the two sides' difference, in standard errors; 0 when both are constant
+static double zScore(const Moments& a, const Moments& b) {
+    double se = sqrt(a.var() / a.n + b.var() / b.n);
+    double d = fabs(a.mean() - b.mean());
+    if (se == 0.0) return d == 0.0 ? 0.0 : INFINITY;
+    return d / se;
+}
+
+template <class Rules, class Duel>
+static Tally run(const Case& c, long long duels, GameRng& rng, Duel duel) {
+    PlayerPool pool;
+    pool.add("p1", c.hits1, c.luck1, 0.0f, 1);
+    pool.add("p2", c.hits2, c.luck2, 0.0f, 1);
+    BasicRPG<Rules> p1(&pool, 0), p2(&pool, 1);
+    Tally t;
+    for (long long i = 0; i < duels; ++i) {
+        pool.hitsTaken(0) = c.hits1;
+        pool.hitsTaken(1) = c.hits2;
+        DuelResult r = duel(p1, p2, rng);
+        t.p1_wins.add(r.winner == 0 ? 1.0 : 0.0);
+        t.swings.add(r.swings);
+        t.winner_hits.add(pool.hitsTaken(r.winner));
+    }
+    return t;
+}
+
+template <class Rules>
+static int check(const Case& c, long long duels, GameRng& rng) {
+    if (c.hits1 >= Rules::MAX_HITS_TAKEN || c.hits2 >= Rules::MAX_HITS_TAKEN) return 0;
+    Tally loop = run<Rules>(c, duels, rng, [](BasicRPG<Rules> a, BasicRPG<Rules> b, GameRng& g) {
+        return simulateDuel(a, b, g);
+    });
+    Tally fast = run<Rules>(c, duels, rng, [](BasicRPG<Rules> a, BasicRPG<Rules> b, GameRng& g) {
+        return resolveDuel(a, b, g);
+    });
+
+    struct { const char* what; const Moments& a; const Moments& b; } stats[] = {
+        { "p1 win rate", loop.p1_wins, fast.p1_wins },
+        { "mean swings", loop.swings, fast.swings },
+        { "winner hits", loop.winner_hits, fast.winner_hits },
+    };
+    int failed = 0;
+    for (const auto& s : stats) {
+        double z = zScore(s.a, s.b);
+        bool ok = z <= MAX_Z;
+        printf("%-4s %-12s luck %.1f/%.1f hits %d/%d  %-11s loop %8.4f  resolve %8.4f  z %5.2f\n",
+               ok ? "ok" : "FAIL", Rules::NAME, c.luck1, c.luck2, c.hits1, c.hits2, s.what,
+               s.a.mean(), s.b.mean(), z);
+        failed += !ok;
+    }
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    long long duels = argc > 1 ? atoll(argv[1]) : 200000;
+    if (duels < 2) {
+        fprintf(stderr, "usage: %s [duels >= 2]\n", argv[0]);
+        return 2;
+    }
+    const Case cases[] = {
+        { 0.0f, 0.0f, 0, 0 },       // every swing lands
+        { 1.0f, 1.0f, 0, 0 },
+        { 3.0f, 0.5f, 0, 0 },       // p2 hits far less often
+        { 0.5f, 5.0f, 0, 0 },
+        { 2.0f, 2.0f, 1, 0 },       // p1 starts a hit down
+        { 2.0f, 2.0f, 0, 2 },
+        { 6.0f, 6.0f, 2, 1 },       // long, even fights
+    };
+    GameRng rng;
+    seedEngine(rng, 20261016);
+    int failed = 0;
+    for (const Case& c : cases) {
+        failed += check<ClassicRules>(c, duels, rng);
+        failed += check<SuddenDeathRules>(c, duels, rng);
+        failed += check<EnduranceRules>(c, duels, rng);
+    }
+    printf("%s: %d comparison%s out of range\n", failed ? "FAILED" : "passed", failed,
+           failed == 1 ? "" : "s");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+// Round trip of the Columnar export through ResultColumns.
+//
+// Build from Lab_3:
+//   g++ -std=c++17 -O2 -pthread export_test.cpp $(ls *.cpp | grep -v -e main.cpp -e bench.cpp -e _test.cpp) -o export_test
+//
+// Run:
+//   ./export_test                  exit status 0 if every case reads back
+//
+// Each case exports a pool, maps the file back and compares every column
+// and every name with the pool it came from: implicit NPC_<i> names, custom
+// names (interned once, shared by many rows, quotes and commas included),
+// a played game, and an empty pool. A cut-short file must not open.
+
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include "Game.h"
+#include "ResultExport.h"
+using namespace std;
+
+static int failures = 0;
+
+static void expect(bool ok, const string& what) {
+    if (!ok) {
+        printf("FAIL %s\n", what.c_str());
+        ++failures;
+    }
+}
+
+static string tempPath(const char* tag) {
+    return "/tmp/lab3_export_test_" + to_string(getpid()) + "_" + tag + ".l3rc";
+}
+
+// exports pool, reads it back, and checks every row
+static void roundTrip(const char* tag, const PlayerPool& pool, int max_hits_taken, int threads) {
+    int before = failures;
+    string path = tempPath(tag);
+    string where = string(tag) + ": ";
+    expect(ResultExporter(threads).write(pool, max_hits_taken, ExportFormat::Columnar, path),
+           where + "write failed");
+    {
+        ResultColumns cols(path);
+        expect(cols.ok(), where + "does not open");
+        if (cols.ok()) {
+            expect(cols.rows() == pool.size(), where + "row count");
+            long long bad = 0;
+            for (int i = 0; i < pool.size() && i < cols.rows(); ++i) {
+                bool alive = pool.hitsTaken(i) < max_hits_taken;
+                bad += cols.hitsTaken()[i] != pool.hitsTaken(i) || cols.luck()[i] != pool.luckOf(i) ||
+                       cols.exp()[i] != pool.expOf(i) || cols.level()[i] != pool.levelOf(i) ||
+                       cols.alive()[i] != (alive ? 1 : 0) || cols.name(i) != pool.nameOf(i);
+            }
+            expect(bad == 0, where + to_string(bad) + " rows differ");
+        }
+    }
+    printf("%-4s %-10s %d rows\n", failures > before ? "FAIL" : "ok", tag, pool.size());
+    unlink(path.c_str());
+}
+
+int main() {
+    // implicit and custom names, more rows than one formatting slice
+    PlayerPool mixed;
+    const char* custom[] = { "Dorito", "So close, \"yet\" so far", "Sir Lancelot", "" };
+    for (int i = 0; i < 300000; ++i) {
+        int id = mixed.add();
+        mixed.hitsTaken(id) = i % 4;
+        mixed.luckOf(id) = 0.1f * (1 + i % 37) + 1e-7f * i;
+        mixed.expOf(id) = 50.0f * (i % 2);
+        mixed.levelOf(id) = 1 + i % 29;
+        const char* name = custom[i % 5 == 0 ? (i / 5) % 3 : 3];
+        if (*name) mixed.setName(id, name);
+    }
+    roundTrip("mixed", mixed, ClassicRules::MAX_HITS_TAKEN, 4);
+
+    // the rows a played game leaves behind
+    Game g(7);
+    g.setEventSink(silentSink());
+    g.setReportStats(false);
+    g.generatePlayers(5000);
+    g.gameLoop();
+    string path = tempPath("game");
+    expect(g.exportResults(path, ExportFormat::Columnar), "game: export failed");
+    {
+        ResultColumns cols(path);
+        long long bad = cols.ok() && cols.rows() == g.getNumPlayers() ? 0 : 1;
+        for (int i = 0; bad == 0 && i < g.getNumPlayers(); ++i) {
+            RPG p = g.getPlayer(i);
+            bad += cols.hitsTaken()[i] != p.getHitsTaken() || cols.luck()[i] != p.getLuck() ||
+                   cols.exp()[i] != p.getExp() || cols.level()[i] != p.getLevel() ||
+                   cols.alive()[i] != (p.isAlive() ? 1 : 0) || cols.name(i) != p.getName();
+        }
+        expect(bad == 0, "game: rows differ");
+        printf("%-4s %-10s %d rows\n", bad ? "FAIL" : "ok", "game", g.getNumPlayers());
+
+        // any truncation loses a column or the names, so the file must not open
+        string cut = tempPath("cut");
+        FILE* in = fopen(path.c_str(), "rb");
+        FILE* out = fopen(cut.c_str(), "wb");
+        long keep = 0;
+        if (in && out) {
+            fseek(in, 0, SEEK_END);
+            keep = ftell(in) - 1;
+            fseek(in, 0, SEEK_SET);
+            for (long i = 0; i < keep; ++i) fputc(fgetc(in), out);
+        }
+        if (in) fclose(in);
+        if (out) fclose(out);
+        expect(keep > 0 && !ResultColumns(cut).ok(), "cut: a truncated file opened");
+        unlink(cut.c_str());
+    }
+    unlink(path.c_str());
+
+    roundTrip("empty", PlayerPool(), ClassicRules::MAX_HITS_TAKEN, 1);
+
+    printf("%s: %d failure%s\n", failures ? "FAILED" : "passed", failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
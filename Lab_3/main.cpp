@@ -1,13 +1,264 @@
 #include <iostream>
+#include <cstdlib>
 #include "RPG.h"
 #include "Game.h"
+#include "Checkpoint.h"
+#include "MonteCarloRunner.h"
+#include "ShardedGame.h"
+#include "SimulationFarm.h"
+#include "Trace.h"
+#include "Rules.h"
+#include <chrono>
+#include <cstring>
+#include <string>
 using namespace std;
 
-int main() {
-    
-    
-    Game g;
-    g.generatePlayers(10);
+// every mode except replay takes --rules=<name> anywhere on the line,
+// bracket also --duels=analytic|swings|interleaved|batched, and the default
+// run --match=uniform|level|luck; both take --live=packed|bits and
+// --checkpoint=<file> [--every=<rounds>] to snapshot the game as it goes and
+// --export=<file> [--format=csv|ndjson|columnar] to save the final results;
+// --roster=<file> fills those two with the file's players instead of NPCs;
+// shards takes --match and --live too. --queue=block|drop|sample prints the
+// rounds of bracket, default and resume through a QueuedSink; mc takes
+// --seconds=<s> to play for a fixed time rather than a game count
+static string      rules = ClassicRules::NAME;
+static DuelMode    duels = DuelMode::Analytic;
+static Matchmaking matching = Matchmaking::Uniform;
+static Liveness    liveness = Liveness::Packed;
+static string      checkpoint;
+static long long   every = 100000;
+static string      export_path;
+static ExportFormat export_format = ExportFormat::Csv;
+static string      roster;
+static double      seconds = 0;      // mc time budget, 0 = count games
+static bool        queued = false;
+static Backpressure backpressure = Backpressure::Block;
+
+// where the round-by-round modes print
+static EventSink& outputSink() {
+    if (!queued) return stdoutSink();
+    static QueuedSink sink(stdout, backpressure);
+    return sink;
+}
+
+// the roster if one was given, else n default players
+template <class Rules>
+static bool addPlayers(BasicGame<Rules>& g, int n) {
+    if (roster.empty()) {
+        g.generatePlayers(n);
+        return true;
+    }
+    string error;
+    if (g.loadPlayers(roster, &error)) {
+        if (g.getNumAlive() > 0) return true;
+        error = roster + ": nobody alive";
+    }
+    cerr << error << '\n';
+    return false;
+}
+
+template <class Rules>
+static int exportIfAsked(const BasicGame<Rules>& g) {
+    if (export_path.empty() || g.exportResults(export_path, export_format)) return 0;
+    cerr << "cannot write " << export_path << '\n';
+    return 1;
+}
+
+static void printMonteCarlo(const MonteCarloResult& r, int players) {
+    cout << "Games: " << r.games << "   Players per game: " << players << '\n';
+    for (int lv = 0; lv < (int)r.champion_levels.size(); ++lv) {
+        if (r.champion_levels[lv] == 0) continue;
+        Interval ci = MonteCarloResult::share(r.champion_levels[lv], r.games);
+        cout << "Champion level " << lv << ": "
+             << 100.0 * r.champion_levels[lv] / r.games << "%   (95% CI "
+             << 100.0 * ci.low << " - " << 100.0 * ci.high << "%)\n";
+    }
+    Interval mean = r.meanChampionLevelInterval();
+    cout << "Mean champion level: " << r.meanChampionLevel() << "   (95% CI "
+         << mean.low << " - " << mean.high << ")\n";
+}
+
+// ./main mc <games> <players> [seed] : many silent games across all cores;
+// with --seconds=<s> as many games as fit in s seconds instead
+static int runMonteCarlo(int argc, char* argv[]) {
+    long long games = (argc > 2) ? strtoll(argv[2], nullptr, 10) : 1000;
+    int players = (argc > 3) ? atoi(argv[3]) : 10;
+    unsigned seed = (argc > 4) ? strtoul(argv[4], nullptr, 10) : 1;
+    if (players < 1) {
+        cerr << "usage: main mc <games> <players> [seed], players at least 1\n";
+        return 1;
+    }
+
+    MonteCarloRunner runner(players, seed, 0, rules);
+    if (seconds > 0) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        MonteCarloResult r = runner.runUntil(start + chrono::duration_cast<chrono::steady_clock::duration>(
+                                                          chrono::duration<double>(seconds)));
+        printMonteCarlo(r, players);
+        cout << "Finished in " << chrono::duration<double>(chrono::steady_clock::now() - start).count()
+             << " s of a " << seconds << " s budget\n";
+        return 0;
+    }
+    printMonteCarlo(runner.run(games), players);
+    return 0;
+}
+
+// ./main farm <games> <players> [seed] [workers] : the same games, one process per worker
+static int runFarm(int argc, char* argv[]) {
+    long long games = (argc > 2) ? strtoll(argv[2], nullptr, 10) : 1000;
+    int players = (argc > 3) ? atoi(argv[3]) : 10;
+    unsigned seed = (argc > 4) ? strtoul(argv[4], nullptr, 10) : 1;
+    int workers = (argc > 5) ? atoi(argv[5]) : 0;
+    if (players < 1) {
+        cerr << "usage: main farm <games> <players> [seed] [workers], players at least 1\n";
+        return 1;
+    }
+
+    SimulationFarm farm(players, seed, workers, rules);
+    MonteCarloResult r = farm.run(games);
+    if (r.games == 0 && games > 0) {
+        cerr << "cannot set up the shared-memory segment\n";
+        return 1;
+    }
+    printMonteCarlo(r, players);
+    if (farm.restarts() > 0) cout << "Workers restarted: " << farm.restarts() << '\n';
+    if (farm.lostGames() > 0) cout << "Games lost to crashing batches: " << farm.lostGames() << '\n';
+    return 0;
+}
+
+// ./main bracket <players> [seed] : single elimination, duels in parallel
+template <class Rules>
+static int runBracket(int argc, char* argv[]) {
+    int players = (argc > 2) ? atoi(argv[2]) : 16;
+    unsigned seed = (argc > 3) ? strtoul(argv[3], nullptr, 10) : 1;
+    if (roster.empty() && players < 1) {
+        cerr << "usage: main bracket <players> [seed], players at least 1\n";
+        return 1;
+    }
+
+    BasicGame<Rules> g(seed);
+    g.setDuelMode(duels);
+    g.setLiveness(liveness);
+    g.setCheckpoint(checkpoint, checkpoint.empty() ? 0 : every);
+    if (!addPlayers(g, players)) return 1;
+    g.setEventSink(g.getNumPlayers() > 64 ? silentSink() : outputSink());
+    g.bracketLoop();
+
+    if (g.getChampion() >= 0) {
+        cout << "Champion after " << g.getRound() << " rounds:\n";
+        g.getPlayer(g.getChampion()).printStats();
+    }
+    return exportIfAsked(g);
+}
+
+// ./main shards <players> [seed] [shards] : one shard per core, then a final
+template <class Rules>
+static int runSharded(int argc, char* argv[]) {
+    long long players = (argc > 2) ? strtoll(argv[2], nullptr, 10) : 1000000;
+    unsigned seed = (argc > 3) ? strtoul(argv[3], nullptr, 10) : 1;
+    int shards = (argc > 4) ? atoi(argv[4]) : 0;
+    if (players < 1) {
+        cerr << "usage: main shards <players> [seed] [shards]\n";
+        return 1;
+    }
+
+    BasicShardedGame<Rules> g(seed, shards);
+    g.setMatchmaking(matching);
+    g.setLiveness(liveness);
+    g.setEventSink(silentSink());
+    g.play(players);
+
+    cout << "Champion of " << g.getNumShards() << " shards after " << g.getRound() << " rounds:\n";
+    g.finalGame().getPlayer(g.finalGame().getChampion()).printStats();
+    return 0;
+}
+
+// ./main trace <players> <file> [seed] : silent gameLoop that records a trace
+template <class Rules>
+static int runTrace(int argc, char* argv[]) {
+    if (argc < 4) {
+        cerr << "usage: main trace <players> <file> [seed]\n";
+        return 1;
+    }
+    int players = atoi(argv[2]);
+    uint64_t seed = (argc > 4) ? strtoull(argv[4], nullptr, 10) : 1;
+
+    BasicGame<Rules> g(seed);
+    TraceWriter trace(argv[3], seed, 0);
+    if (!trace.ok()) {
+        cerr << "cannot write " << argv[3] << '\n';
+        return 1;
+    }
+    g.setEventSink(silentSink());
+    g.setTrace(&trace);
+    g.generatePlayers(players);
+    g.gameLoop();
+    trace.close();
+    cout << "Traced " << g.getRound() << " rounds to " << argv[3] << '\n';
+    return 0;
+}
+
+// ./main replay <file> [player] : print a trace, or one player's events
+static int runReplay(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "usage: main replay <file> [player]\n";
+        return 1;
+    }
+    TraceReader reader(argv[2]);
+    if (!reader.ok()) {
+        cerr << "not a trace: " << argv[2] << '\n';
+        return 1;
+    }
+    auto print = [](const TraceEvent& e) {
+        if (e.kind == TRACE_SWING) {
+            cout << "round " << e.round << ": NPC_" << e.attacker << " swings at NPC_" << e.defender
+                 << (e.hit ? " and hits\n" : " and misses\n");
+        } else {
+            cout << "round " << e.round << ": NPC_" << e.attacker << " beats NPC_" << e.defender
+                 << "   Exp: " << e.exp << "   Level +" << e.level_delta << '\n';
+        }
+    };
+    if (argc > 3) reader.forPlayer(atoi(argv[3]), print);
+    else reader.forEach(print);
+    if (!reader.intact()) {
+        cerr << "trace damaged, some events skipped: " << argv[2] << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+// ./main resume <file> : finish a checkpointed bracket or default run
+template <class Rules>
+static int runResume(const char* path) {
+    BasicGame<Rules> g;
+    if (!g.resume(path)) {
+        cerr << "cannot resume from " << path << '\n';
+        return 1;
+    }
+    g.setCheckpoint(checkpoint, checkpoint.empty() ? 0 : every);
+    g.setEventSink(g.getNumPlayers() > 64 ? silentSink() : outputSink());
+    cout << "Resuming at round " << g.getRound() << " with " << g.getNumAlive() << " alive\n";
+    g.resumeLoop();
+
+    if (g.getChampion() >= 0) {
+        cout << "Champion after " << g.getRound() << " rounds:\n";
+        g.getPlayer(g.getChampion()).printStats();
+    }
+    return exportIfAsked(g);
+}
+
+// ./main [seed] : ten players, every round printed, then the final table
+template <class Rules>
+static int runDefault(int argc, char* argv[]) {
+    // optional seed so a run can be reproduced: ./main 42
+    BasicGame<Rules> g = (argc > 1) ? BasicGame<Rules>(strtoul(argv[1], nullptr, 10))
+                                    : BasicGame<Rules>();
+    g.setMatchmaking(matching);
+    g.setLiveness(liveness);
+    g.setCheckpoint(checkpoint, checkpoint.empty() ? 0 : every);
+    if (!addPlayers(g, 10)) return 1;
+    g.setEventSink(g.getNumPlayers() > 64 ? silentSink() : outputSink());
     g.gameLoop();
     g.printFinalResults();
 
@@ -15,7 +266,124 @@ int main() {
     /* Yes but I would have to make an accessor. 
     ~something like getLivePlayers*/
 
-    return 0;
-    
+    return exportIfAsked(g);
+}
+
+// Pulls the --name=value flags out of argv so the modes see their usual positions.
+static bool takeFlags(int& argc, char* argv[]) {
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--rules=", 8) == 0) {
+            rules = argv[i] + 8;
+        } else if (strncmp(argv[i], "--duels=", 8) == 0) {
+            string d = argv[i] + 8;
+            if (d == "analytic") duels = DuelMode::Analytic;
+            else if (d == "swings") duels = DuelMode::Swings;
+            else if (d == "interleaved") duels = DuelMode::Interleaved;
+            else if (d == "batched") duels = DuelMode::Batched;
+            else {
+                cerr << "unknown duels: " << d << " (have analytic, swings, interleaved, batched)\n";
+                return false;
+            }
+        } else if (strncmp(argv[i], "--live=", 7) == 0) {
+            string l = argv[i] + 7;
+            if (l == "packed") liveness = Liveness::Packed;
+            else if (l == "bits") liveness = Liveness::Bitset;
+            else {
+                cerr << "unknown live: " << l << " (have packed, bits)\n";
+                return false;
+            }
+        } else if (strncmp(argv[i], "--checkpoint=", 13) == 0) {
+            checkpoint = argv[i] + 13;
+        } else if (strncmp(argv[i], "--every=", 8) == 0) {
+            every = strtoll(argv[i] + 8, nullptr, 10);
+            if (every <= 0) {
+                cerr << "--every needs a positive round count\n";
+                return false;
+            }
+        } else if (strncmp(argv[i], "--export=", 9) == 0) {
+            export_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            string f = argv[i] + 9;
+            if (f == "csv") export_format = ExportFormat::Csv;
+            else if (f == "ndjson") export_format = ExportFormat::Ndjson;
+            else if (f == "columnar") export_format = ExportFormat::Columnar;
+            else {
+                cerr << "unknown format: " << f << " (have csv, ndjson, columnar)\n";
+                return false;
+            }
+        } else if (strncmp(argv[i], "--seconds=", 10) == 0) {
+            seconds = strtod(argv[i] + 10, nullptr);
+            if (!(seconds > 0)) {
+                cerr << "--seconds needs a positive time\n";
+                return false;
+            }
+        } else if (strncmp(argv[i], "--queue=", 8) == 0) {
+            string q = argv[i] + 8;
+            queued = true;
+            if (q == "block") backpressure = Backpressure::Block;
+            else if (q == "drop") backpressure = Backpressure::Drop;
+            else if (q == "sample") backpressure = Backpressure::Sample;
+            else {
+                cerr << "unknown queue: " << q << " (have block, drop, sample)\n";
+                return false;
+            }
+        } else if (strncmp(argv[i], "--roster=", 9) == 0) {
+            roster = argv[i] + 9;
+        } else if (strncmp(argv[i], "--match=", 8) == 0) {
+            string m = argv[i] + 8;
+            if (m == "uniform") matching = Matchmaking::Uniform;
+            else if (m == "level") matching = Matchmaking::ByLevel;
+            else if (m == "luck") matching = Matchmaking::ByLuck;
+            else {
+                cerr << "unknown match: " << m << " (have uniform, level, luck)\n";
+                return false;
+            }
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    argv[argc] = nullptr;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (!takeFlags(argc, argv)) return 1;
+    if (argc > 1 && strcmp(argv[1], "replay") == 0) {
+        return runReplay(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "resume") == 0) {
+        // the checkpoint names its rule set, --rules does not apply
+        if (argc < 3) {
+            cerr << "usage: main resume <file>\n";
+            return 1;
+        }
+        string written_by = CheckpointReader(argv[2]).rules();
+        int status = 1;
+        if (!withRules(written_by, [&](auto r) { status = runResume<decltype(r)>(argv[2]); })) {
+            cerr << "not a checkpoint: " << argv[2] << '\n';
+        }
+        return status;
+    }
+    if (!withRules(rules, [](auto) {})) {
+        cerr << "unknown rules: " << rules << " (have " << rulesNames() << ")\n";
+        return 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "mc") == 0) {
+        return runMonteCarlo(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "farm") == 0) {
+        return runFarm(argc, argv);
+    }
 
+    int status = 0;
+    withRules(rules, [&](auto r) {
+        typedef decltype(r) Rules;
+        if (argc > 1 && strcmp(argv[1], "bracket") == 0) status = runBracket<Rules>(argc, argv);
+        else if (argc > 1 && strcmp(argv[1], "trace") == 0) status = runTrace<Rules>(argc, argv);
+        else if (argc > 1 && strcmp(argv[1], "shards") == 0) status = runSharded<Rules>(argc, argv);
+        else status = runDefault<Rules>(argc, argv);
+    });
+    return status;
 }